@@ -21,6 +21,7 @@
 // Based on the original Grids by Emilie Gillet.
 
 #include "distingnt/api.h"
+#include <cstdint>
 #include <cstring>
 #include <new>
 
@@ -39,6 +40,9 @@
 // --- ParameterDefinitions (s_parameters array, etc.) ---
 static const char *kEnumModeStrings[] = {"Euclidean", "Drums", NULL};
 static const char *kEnumBooleanStrings[] = {"Off", "On", NULL};
+static const char *kEnumClockSourceStrings[] = {"External", "Internal", NULL};
+static const char *kEnumClockResolutionStrings[] = {"4 PPQN", "8 PPQN", "24 PPQN", NULL};
+static const char *kEnumClockScaleStrings[] = {"/4", "/3", "/2", "x1", "x2", "x3", "x4", "x6", "x8", "x12", "x24", NULL};
 
 // Define s_parameters (matches extern declaration in nt_grids.h)
 // clang-format off
@@ -52,48 +56,65 @@ const _NT_parameter s_parameters[] = {
     {.name = "Drum Density 2", .min = 0, .max = 255, .def = 128, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
     {.name = "Drum Density 3", .min = 0, .max = 255, .def = 128, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
     {.name = "Euclid Len/Ctrl", .min = 0, .max = 2, .def = 0, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Length", "Fill", "Shift", NULL}},
-    {.name = "Euclid Length 1", .min = 1, .max = 16, .def = 8, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
-    {.name = "Euclid Fill 1", .min = 0, .max = 16, .def = 4, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
-    {.name = "Euclid Shift 1", .min = 0, .max = 15, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
-    {.name = "Euclid Length 2", .min = 1, .max = 16, .def = 8, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
-    {.name = "Euclid Fill 2", .min = 0, .max = 16, .def = 4, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
-    {.name = "Euclid Shift 2", .min = 0, .max = 15, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
-    {.name = "Euclid Length 3", .min = 1, .max = 16, .def = 8, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
-    {.name = "Euclid Fill 3", .min = 0, .max = 16, .def = 4, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
-    {.name = "Euclid Shift 3", .min = 0, .max = 15, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
+    {.name = "Euclid Length 1", .min = 1, .max = 32, .def = 8, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
+    {.name = "Euclid Fill 1", .min = 0, .max = 32, .def = 4, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
+    {.name = "Euclid Shift 1", .min = 0, .max = 31, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
+    {.name = "Euclid Length 2", .min = 1, .max = 32, .def = 8, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
+    {.name = "Euclid Fill 2", .min = 0, .max = 32, .def = 4, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
+    {.name = "Euclid Shift 2", .min = 0, .max = 31, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
+    {.name = "Euclid Length 3", .min = 1, .max = 32, .def = 8, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
+    {.name = "Euclid Fill 3", .min = 0, .max = 32, .def = 4, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
+    {.name = "Euclid Shift 3", .min = 0, .max = 31, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
     NT_PARAMETER_CV_INPUT("Clock Input", 0, 1)
     NT_PARAMETER_CV_INPUT("Reset Input", 0, 2)
     NT_PARAMETER_CV_OUTPUT_WITH_MODE("Trig 1 Output", 0, 15)
     NT_PARAMETER_CV_OUTPUT_WITH_MODE("Trig 2 Output", 0, 16)
     NT_PARAMETER_CV_OUTPUT_WITH_MODE("Trig 3 Output", 0, 17)
     NT_PARAMETER_CV_OUTPUT_WITH_MODE("Accent Output", 0, 18)
+    {.name = "Trig 1 Length", .min = 1, .max = 100, .def = 5, .unit = kNT_unitMs, .scaling = 0, .enumStrings = NULL},
+    {.name = "Trig 2 Length", .min = 1, .max = 100, .def = 5, .unit = kNT_unitMs, .scaling = 0, .enumStrings = NULL},
+    {.name = "Trig 3 Length", .min = 1, .max = 100, .def = 5, .unit = kNT_unitMs, .scaling = 0, .enumStrings = NULL},
+    {.name = "Accent Length", .min = 1, .max = 100, .def = 5, .unit = kNT_unitMs, .scaling = 0, .enumStrings = NULL},
+    {.name = "Clock High", .min = 0, .max = 100, .def = 10, .unit = kNT_unitVolts, .scaling = kNT_scaling10, .enumStrings = NULL},
+    {.name = "Clock Low", .min = 0, .max = 100, .def = 5, .unit = kNT_unitVolts, .scaling = kNT_scaling10, .enumStrings = NULL},
+    {.name = "Clock Min Gap", .min = 0, .max = 4800, .def = 0, .unit = kNT_unitFrames, .scaling = 0, .enumStrings = NULL},
+    {.name = "Chaos Seed", .min = 0, .max = 32767, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
+    {.name = "Drum Length", .min = 1, .max = 32, .def = 32, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
+    {.name = "Clock Source", .min = 0, .max = 1, .def = 0, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = kEnumClockSourceStrings},
+    {.name = "Tempo", .min = 200, .max = 3000, .def = 1200, .unit = kNT_unitBPM, .scaling = kNT_scaling10, .enumStrings = NULL},
+    {.name = "Clock Timeout", .min = 0, .max = 8, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL},
+    {.name = "Clock Mult/Div", .min = 0, .max = 10, .def = 3, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = kEnumClockScaleStrings},
+    {.name = "Clock Resolution", .min = 0, .max = 2, .def = 1, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = kEnumClockResolutionStrings},
 };
 // clang-format on
 // Note: kNumParameters enum value must match the size implicitly
 
-static const uint8_t NUM_TRIGGER_STEPS = 5;
-
 // --- Parameter Pages ---
 static const uint8_t s_page_main[] = {
     kParamMode,
     kParamChaosEnable,
     kParamChaosAmount,
+    kParamChaosSeed,
 };
 static const uint8_t s_page_drum[] = {
     kParamDrumMapX, kParamDrumMapY, kParamChaosAmount,
-    kParamDrumDensity1, kParamDrumDensity2, kParamDrumDensity3};
+    kParamDrumDensity1, kParamDrumDensity2, kParamDrumDensity3,
+    kParamDrumLength};
 static const uint8_t s_page_euclidean[] = {
     kParamEuclideanControlsLength, // Added to page
     kParamEuclideanLength1, kParamEuclideanFill1, kParamEuclideanShift1,
     kParamEuclideanLength2, kParamEuclideanFill2, kParamEuclideanShift2,
     kParamEuclideanLength3, kParamEuclideanFill3, kParamEuclideanShift3};
 static const uint8_t s_page_routing[] = {
-    kParamClockInput,
+    kParamClockSource,
+    kParamClockInput, kParamClockScale, kParamClockResolution,
+    kParamTempo,
     kParamResetInput,
-    kParamOutputTrig1, kParamOutputTrig1Mode,
-    kParamOutputTrig2, kParamOutputTrig2Mode,
-    kParamOutputTrig3, kParamOutputTrig3Mode,
-    kParamOutputAccent, kParamOutputAccentMode};
+    kParamClockHigh, kParamClockLow, kParamClockMinInterval, kParamClockTimeout,
+    kParamOutputTrig1, kParamOutputTrig1Mode, kParamTrig1Length,
+    kParamOutputTrig2, kParamOutputTrig2Mode, kParamTrig2Length,
+    kParamOutputTrig3, kParamOutputTrig3Mode, kParamTrig3Length,
+    kParamOutputAccent, kParamOutputAccentMode, kParamAccentLength};
 
 static const _NT_parameterPage s_pages[] = {
     {.name = "Main", .numParams = ARRAY_SIZE(s_page_main), .params = s_page_main},
@@ -109,69 +130,253 @@ const _NT_parameterPages parameterPages = {
 
 // --- Helper: Update Grids PatternGenerator from parameters ---
 // This function must be static as it's a file-scope helper
-static void update_grids_from_params(const int16_t *param_values) // Changed to const int16_t*
+static void update_grids_from_params(nt_grids_port::grids::PatternGenerator &generator, const int16_t *param_values)
 {
   using namespace nt_grids_port::grids;
 
-  OutputMode previous_mode = PatternGenerator::current_output_mode();
+  OutputMode previous_mode = generator.current_output_mode();
   OutputMode new_mode = (OutputMode)param_values[kParamMode]; // param_values are int16_t
 
   if (new_mode != previous_mode)
   {
-    PatternGenerator::set_output_mode(new_mode);
+    generator.set_output_mode(new_mode);
   }
-  OutputMode current_mode = PatternGenerator::current_output_mode();
+  OutputMode current_mode = generator.current_output_mode();
 
+  // Only settings that differ are written, and the lookahead is only dropped if one did: this
+  // runs for every parameter change (tempo, routing, a density under CV...). The refill is left
+  // to the end of the next block.
+  bool changed = false;
   if (current_mode == OUTPUT_MODE_DRUMS)
   {
     // Values from param_values are int16_t, PatternGenerator expects uint8_t or similar
-    PatternGenerator::settings_[current_mode].options.drums.x = (uint8_t)param_values[kParamDrumMapX];
-    PatternGenerator::settings_[current_mode].options.drums.y = (uint8_t)param_values[kParamDrumMapY];
-    PatternGenerator::settings_[current_mode].density[0] = (uint8_t)param_values[kParamDrumDensity1];
-    PatternGenerator::settings_[current_mode].density[1] = (uint8_t)param_values[kParamDrumDensity2];
-    PatternGenerator::settings_[current_mode].density[2] = (uint8_t)param_values[kParamDrumDensity3];
+    PatternGeneratorSettings &drums = generator.settings_[OUTPUT_MODE_DRUMS];
+    uint8_t x = (uint8_t)param_values[kParamDrumMapX];
+    uint8_t y = (uint8_t)param_values[kParamDrumMapY];
+    changed |= drums.options.drums.x != x || drums.options.drums.y != y;
+    drums.options.drums.x = x;
+    drums.options.drums.y = y;
+    for (int i = 0; i < nt_grids_port::kNumParts; ++i)
+    {
+      uint8_t density = (uint8_t)param_values[kParamDrumDensity1 + i];
+      changed |= drums.density[i] != density;
+      drums.density[i] = density;
+    }
+    generator.PrepareDrumLevels(); // Rebuild the drum rank tables here, not in the audio path
+    if (generator.pattern_length() != (uint8_t)param_values[kParamDrumLength])
+    {
+      generator.SetPatternLength((uint8_t)param_values[kParamDrumLength]);
+    }
   }
   else // OUTPUT_MODE_EUCLIDEAN
   {
+    if (generator.pattern_length() != nt_grids_port::kStepsPerPattern)
+    {
+      generator.SetPatternLength(nt_grids_port::kStepsPerPattern); // Euclidean parts have their own lengths
+    }
     for (int i = 0; i < nt_grids_port::kNumParts; ++i)
     {
+      // The setters rebuild the part's mask and drop the lookahead themselves.
       uint8_t length = (uint8_t)param_values[kParamEuclideanLength1 + i * 3]; // Corrected indexing for Length, Fill, Shift
-      PatternGenerator::SetLength(i, length);
+      if (generator.current_euclidean_length_[i] != length)
+        generator.SetLength(i, length);
 
       uint8_t fill_density_param_val = (uint8_t)param_values[kParamEuclideanFill1 + i * 3]; // Corrected indexing
-      PatternGenerator::SetFill(i, fill_density_param_val);
+      if (generator.settings_[OUTPUT_MODE_EUCLIDEAN].density[i] != fill_density_param_val)
+        generator.SetFill(i, fill_density_param_val);
 
-      // uint8_t shift_param_val = (uint8_t)param_values[kParamEuclideanShift1 + i * 3]; // Corrected indexing
-      // PatternGenerator::SetShift(i, shift_param_val);
+      uint8_t shift_param_val = (uint8_t)param_values[kParamEuclideanShift1 + i * 3];
+      if (generator.euclidean_shift_[i] != shift_param_val)
+        generator.SetShift(i, shift_param_val);
     }
   }
 
-  PatternGenerator::set_global_chaos(param_values[kParamChaosEnable] != 0);
+  // The internal clock ticks once per step; Clock Resolution describes the external clock.
+  generator.set_clock_resolution((param_values[kParamClockSource] != 0)
+                                     ? CLOCK_RESOLUTION_8_PPQN
+                                     : (ClockResolution)param_values[kParamClockResolution]);
+  bool chaos_enabled = param_values[kParamChaosEnable] != 0;
+  if (generator.chaos_globally_enabled_ != chaos_enabled)
+    generator.set_global_chaos(chaos_enabled);
+  if (generator.seed() != (uint32_t)param_values[kParamChaosSeed])
+    generator.set_seed((uint32_t)param_values[kParamChaosSeed]);
+
+  uint8_t chaos_val = generator.chaos_globally_enabled_ ? (uint8_t)param_values[kParamChaosAmount] : 0;
+  changed |= generator.settings_[OUTPUT_MODE_DRUMS].options.drums.randomness != chaos_val ||
+             generator.settings_[OUTPUT_MODE_EUCLIDEAN].options.euclidean.chaos_amount != chaos_val;
+  generator.settings_[OUTPUT_MODE_DRUMS].options.drums.randomness = chaos_val;
+  generator.settings_[OUTPUT_MODE_EUCLIDEAN].options.euclidean.chaos_amount = chaos_val;
+
+  // The settings above are written directly, so the precomputed steps are stale.
+  if (changed)
+  {
+    generator.InvalidateLookahead();
+  }
+}
+
+static const int kNumBusses = 28; // CV/audio busses available to the algorithm
 
-  if (PatternGenerator::chaos_globally_enabled_)
+// Where clock ticks come from, as the step kernel is specialised for it.
+enum ClockSource
+{
+  kClockSourceNone,           // External clock selected but its input is not routed
+  kClockSourceExternal,       // Rising edges on the clock input
+  kClockSourceExternalScaled, // Rising edges on the clock input, multiplied or divided
+  kClockSourceInternal        // The internal clock's phase accumulator
+};
+
+// Kernel selection, defined with the kernels further down.
+static OutputKernel output_kernel(bool enabled, bool replace);
+static StepKernel step_kernel_for(ClockSource clock_source, bool reset_routed);
+static inline int input_bus_index(int16_t bus_param);
+
+// --- Helper: Rebuild the output routing table from the routing parameters ---
+static void update_output_routes(NtGridsAlgorithm *self)
+{
+  static const ParameterIndex bus_params[4] = {kParamOutputTrig1, kParamOutputTrig2, kParamOutputTrig3, kParamOutputAccent};
+  static const ParameterIndex mode_params[4] = {kParamOutputTrig1Mode, kParamOutputTrig2Mode, kParamOutputTrig3Mode, kParamOutputAccentMode};
+  for (int i = 0; i < 4; ++i)
   {
-    uint8_t chaos_val = (uint8_t)param_values[kParamChaosAmount];
-    PatternGenerator::settings_[OUTPUT_MODE_DRUMS].options.drums.randomness = chaos_val;
-    PatternGenerator::settings_[OUTPUT_MODE_EUCLIDEAN].options.euclidean.chaos_amount = chaos_val;
+    int bus_idx = self->v[bus_params[i]] - 1;
+    OutputRoute &route = self->output_routes[i];
+    route.enabled = bus_idx >= 0 && bus_idx < kNumBusses;
+    route.bus_index = route.enabled ? (uint8_t)bus_idx : 0;
+    route.replace = self->v[mode_params[i]] != 0;
+    route.render = output_kernel(route.enabled, route.replace);
   }
-  else
+}
+
+// --- Helper: Pick the step kernel for the clock source and clock/reset routing ---
+// An input that is not read (not routed, or the clock input under the internal clock) reads as
+// low, so its latch is cleared here rather than per block.
+static void update_input_routes(NtGridsAlgorithm *self)
+{
+  int clock_bus = input_bus_index(self->v[kParamClockInput]);
+  int reset_bus = input_bus_index(self->v[kParamResetInput]);
+  bool scaled = self->clock_scaler.multiply > 1 || self->clock_scaler.divide > 1;
+  ClockSource clock_source = (self->v[kParamClockSource] != 0) ? kClockSourceInternal
+                             : (clock_bus < 0)                 ? kClockSourceNone
+                             : scaled                          ? kClockSourceExternalScaled
+                                                               : kClockSourceExternal;
+  self->clock_bus_index = (uint8_t)(clock_bus >= 0 ? clock_bus : 0);
+  self->reset_bus_index = (uint8_t)(reset_bus >= 0 ? reset_bus : 0);
+  if (clock_source == kClockSourceNone || clock_source == kClockSourceInternal)
+  {
+    self->clock_edge_state.above = 0;
+    self->clock_tracker.has_edge = false; // Restart tracking when the external clock returns
+    self->clock_tracker.freewheeling = false;
+    self->clock_tracker.freewheeled = 0;
+    self->clock_scaler.pending = 0;
+    self->clock_scaler.unspaced = 0;
+  }
+  if (reset_bus < 0)
+    self->reset_edge_state.above = 0;
+  self->step_kernel = step_kernel_for(clock_source, reset_bus >= 0);
+}
+
+// --- Helper: External clock multiply/divide ---
+// Restarts the stage: the next input plays, and no sub-ticks of the old ratio are left pending.
+// Call update_input_routes afterwards, which picks the scaled kernel only for ratios other than x1.
+static const uint8_t kClockScaleMultiply[] = {1, 1, 1, 1, 2, 3, 4, 6, 8, 12, 24};
+static const uint8_t kClockScaleDivide[] = {4, 3, 2, 1, 1, 1, 1, 1, 1, 1, 1};
+
+static void update_clock_scale(NtGridsAlgorithm *self)
+{
+  int index = self->v[kParamClockScale];
+  self->clock_scaler.multiply = kClockScaleMultiply[index];
+  self->clock_scaler.divide = kClockScaleDivide[index];
+  self->clock_scaler.divide_phase = 0;
+  self->clock_scaler.pending = 0;
+  self->clock_scaler.unspaced = 0;
+}
+
+// --- Helper: Internal clock rate ---
+// Ticks per sample = BPM / 60 * ticks per beat / sample rate, as a fraction of 2^32 per sample.
+// Tempo is in tenths of a BPM. The clock ticks once per step, 8 steps to the quarter note, so
+// every tick plays a step. The accumulator phase is kept, so a tempo change takes effect from
+// the current position in the tick.
+static const int kInternalClockTicksPerBeat = 8;
+
+static void update_internal_clock(NtGridsAlgorithm *self)
+{
+  double bpm = self->v[kParamTempo] * 0.1;
+  double ticks_per_second = bpm / 60.0 * kInternalClockTicksPerBeat;
+  double increment = ticks_per_second / self->m_platform_adapter.getSampleRate() * 4294967296.0;
+  if (increment > 4294967295.0) // At most one tick per sample
+    increment = 4294967295.0;
+  if (increment < 1.0)
+    increment = 1.0;
+  self->internal_clock.increment = (uint32_t)(increment + 0.5);
+}
+
+// --- Helper: Convert the trigger length parameters (ms) to sample counts ---
+static void update_trigger_lengths(NtGridsAlgorithm *self)
+{
+  float samples_per_ms = self->m_platform_adapter.getSampleRate() / 1000.0f;
+  for (int i = 0; i < 4; ++i)
   {
-    PatternGenerator::settings_[OUTPUT_MODE_DRUMS].options.drums.randomness = 0;
-    PatternGenerator::settings_[OUTPUT_MODE_EUCLIDEAN].options.euclidean.chaos_amount = 0;
+    float length_ms = (float)self->v[kParamTrig1Length + i];
+    uint32_t length_samples = (uint32_t)(length_ms * samples_per_ms + 0.5f);
+    self->trigger_length_samples[i] = (length_samples > 0) ? length_samples : 1;
   }
 }
 
+// --- Helper: Build the clock/reset detector settings from the threshold parameters ---
+// Thresholds are in tenths of a volt. A low threshold above the high one is clamped to it,
+// which gives a plain comparator rather than an inverted latch.
+static void update_input_config(NtGridsAlgorithm *self)
+{
+  float high = self->v[kParamClockHigh] * 0.1f;
+  float low = self->v[kParamClockLow] * 0.1f;
+  if (low > high)
+    low = high;
+  self->clock_edge_config.high = high;
+  self->clock_edge_config.low = low;
+  self->clock_edge_config.min_interval = (uint32_t)self->v[kParamClockMinInterval];
+  self->reset_edge_config.high = high;
+  self->reset_edge_config.low = low;
+  self->reset_edge_config.min_interval = 0;
+}
+
 // --- NtGridsAlgorithm Constructor Definition ---
 NtGridsAlgorithm::NtGridsAlgorithm()
     : m_platform_adapter(this),
       m_euclidean_mode_strategy(this)
 {
-  prev_clock_cv_val = 0.0f;
-  prev_reset_cv_val = 0.0f;
   for (int i = 0; i < 4; ++i)
   {
-    trigger_active_steps_remaining[i] = 0;
+    trigger_samples_remaining[i] = 0;
+    trigger_last_high[i] = false;
+    trigger_length_samples[i] = 1;
+    output_routes[i].bus_index = 0;
+    output_routes[i].replace = false;
+    output_routes[i].enabled = false;
+    output_routes[i].render = output_kernel(false, false);
   }
+  clock_bus_index = 0;
+  reset_bus_index = 0;
+  internal_clock.phase = 0;
+  internal_clock.increment = 1;
+  clock_tracker.block_start = 0;
+  clock_tracker.last_edge = 0;
+  clock_tracker.anchor = 0;
+  clock_tracker.period_q4 = 0;
+  clock_tracker.candidate_q4 = 0;
+  clock_tracker.freewheeled = 0;
+  clock_tracker.anchor_frac = 0;
+  clock_tracker.timeout = 0;
+  clock_tracker.has_edge = false;
+  clock_tracker.freewheeling = false;
+  clock_scaler.anchor = 0;
+  clock_scaler.step_q4 = 0;
+  clock_scaler.multiply = 1;
+  clock_scaler.divide = 1;
+  clock_scaler.divide_phase = 0;
+  clock_scaler.pending = 0;
+  clock_scaler.unspaced = 0;
+  clock_scaler.index = 0;
+  step_kernel = step_kernel_for(kClockSourceNone, false);
+  idle_blocks_skipped = 0;
   m_last_mode = -1; // Initialize to an invalid mode to ensure first mode set is detected
   m_current_mode_strategy = nullptr;
 
@@ -190,8 +395,7 @@ static void nt_grids_calculate_static_requirements(_NT_staticRequirements &req)
 
 static void nt_grids_initialise(_NT_staticMemoryPtrs &ptrs, const _NT_staticRequirements &req) // Original Signature
 {
-  nt_grids_port::Random::Init();
-  nt_grids_port::grids::PatternGenerator::Init();
+  // Nothing shared to set up: each instance owns its PatternGenerator (see NtGridsAlgorithm).
 }
 
 // Original Signature for calculateRequirements
@@ -233,8 +437,15 @@ static _NT_algorithm *nt_grids_construct(const _NT_algorithmMemoryPtrs &ptrs, co
     alg->m_current_mode_strategy->onModeActivated(alg);
   }
 
-  update_grids_from_params(alg->v);
-  nt_grids_port::grids::PatternGenerator::Reset();
+  update_grids_from_params(alg->pattern_generator, alg->v);
+  update_trigger_lengths(alg);
+  update_output_routes(alg);
+  update_clock_scale(alg);
+  update_input_routes(alg);
+  update_internal_clock(alg);
+  alg->clock_tracker.timeout = (uint8_t)alg->v[kParamClockTimeout];
+  update_input_config(alg);
+  alg->pattern_generator.Reset();
   return reinterpret_cast<_NT_algorithm *>(alg);
 }
 
@@ -270,149 +481,563 @@ static void nt_grids_parameter_changed(_NT_algorithm *self_base, int p_idx)
       }
     }
   }
-  update_grids_from_params(self_base->v); // This is now active
+  if (p_idx == kParamClockScale)
+  {
+    update_clock_scale(self);
+  }
+  if (p_idx == kParamClockInput || p_idx == kParamResetInput || p_idx == kParamClockSource || p_idx == kParamClockScale)
+  {
+    update_input_routes(self);
+  }
+  if (p_idx == kParamTempo)
+  {
+    update_internal_clock(self);
+  }
+  if (p_idx == kParamClockTimeout && self->clock_tracker.timeout != (uint8_t)self->v[kParamClockTimeout])
+  {
+    // The timeout counts from now: the anchor is the last tick, which may be long past if the
+    // clock stopped while the timeout was off.
+    self->clock_tracker.timeout = (uint8_t)self->v[kParamClockTimeout];
+    self->clock_tracker.anchor = self->clock_tracker.block_start;
+    self->clock_tracker.anchor_frac = 0;
+  }
+  if (p_idx >= kParamOutputTrig1 && p_idx <= kParamOutputAccentMode)
+  {
+    update_output_routes(self);
+  }
+  if (p_idx >= kParamTrig1Length && p_idx <= kParamAccentLength)
+  {
+    update_trigger_lengths(self);
+  }
+  if (p_idx >= kParamClockHigh && p_idx <= kParamClockMinInterval)
+  {
+    update_input_config(self);
+  }
+  update_grids_from_params(self->pattern_generator, self_base->v);
 }
 
-// Original Signature for step, but with new internal logic
-static void nt_grids_step(_NT_algorithm *self_base, float *busFrames, int numFramesBy4)
+// --- In-block clock/reset events ---
+// Every clock tick and reset detected in a block is recorded with its sample offset and the
+// pattern state it produced, so the output loop can play each evaluated step at its own
+// position even when several ticks land in the same block. Ticks on the same sample share one
+// event (an output can only rise once per sample), so there is at most one tick event per
+// sample plus, around each reset, the reset and the ticks after it on its sample. A reset edge
+// needs two samples, so a block of n frames needs at most n + 2 x n / 2 events however fast
+// the clock is multiplied.
+static const uint8_t kEventTick = 1 << 0;
+static const uint8_t kEventReset = 1 << 1;
+static const int kMaxBlockFrames = 128; // Longest block the event buffer is sized for
+static const int kMaxBlockEvents = 2 * kMaxBlockFrames;
+
+struct BlockEvent
 {
-  NtGridsAlgorithm *self = static_cast<NtGridsAlgorithm *>(self_base); // Use static_cast
-  using nt_grids_port::grids::PatternGenerator;
-  int num_frames_total = numFramesBy4 * 4; // Total samples in the block
+  uint16_t sample_offset;
+  uint8_t state; // PatternGenerator state after the event
+  uint8_t flags; // kEventTick and/or kEventReset
+};
+
+static int push_block_event(BlockEvent *events, int num_events, int sample_offset, uint8_t state, uint8_t flags)
+{
+  if (num_events != 0 && flags == kEventTick && events[num_events - 1].flags == kEventTick &&
+      events[num_events - 1].sample_offset == sample_offset)
+  {
+    events[num_events - 1].state |= state; // Another step on the same sample (multiplied clock)
+    return num_events;
+  }
+  if (num_events == kMaxBlockEvents)
+  {
+    // Out of room (only possible with blocks longer than kMaxBlockFrames): fold into the last
+    // event so no step's triggers are dropped.
+    events[num_events - 1].state |= state;
+    events[num_events - 1].flags |= flags;
+    return num_events;
+  }
+  events[num_events].sample_offset = (uint16_t)sample_offset;
+  events[num_events].state = state;
+  events[num_events].flags = flags;
+  return num_events + 1;
+}
+
+// --- Input bus lookup ---
+// Clock/reset bus parameters are 1-based with 0 = Off. Returns -1 when the input is Off or out
+// of range, which selects a step kernel that never scans it.
+static const int kEdgeScanChunk = 128;
+
+static inline int input_bus_index(int16_t bus_param)
+{
+  if (bus_param <= 0 || bus_param > kNumBusses)
+    return -1;
+  return bus_param - 1;
+}
+
+// --- Output span writers ---
+// Plain counted loops over a contiguous span so the compiler can vectorise/unroll them.
+static inline void replace_span(float *out, int count, float value)
+{
+  for (int k = 0; k < count; ++k)
+  {
+    out[k] = value;
+  }
+}
+
+static inline void add_span(float *out, int count, float value)
+{
+  for (int k = 0; k < count; ++k)
+  {
+    out[k] += value;
+  }
+}
 
-  const float cv_threshold = 0.5f;
+// --- Idle block detection ---
+// A block is idle when no clock or reset arrived and no trigger is still running: every
+// output is low for the whole block.
+static bool is_idle_block(const NtGridsAlgorithm *self, int num_events)
+{
+  if (num_events != 0)
+    return false;
+  uint32_t active = 0;
+  for (int i = 0; i < 4; ++i)
+  {
+    active |= self->trigger_samples_remaining[i];
+  }
+  return active == 0;
+}
 
-  bool tick_this_step = false;
+// --- Output kernels ---
+// Renders one output for a block. Events are applied in order at their offsets: a reset cuts
+// the active trigger, and a tick starts a trigger (trigger_length_samples[i] long) if the
+// output's bit is set in that step's state. Between events the output is a constant-value span
+// (high while the trigger has samples left, then low), written with the span writers above.
+// The trigger rises on the sample of the clock edge and may end partway through this or a later
+// block. Every trigger gets its own rising edge: a tick that lands while the previous trigger is
+// still high cuts it one sample short, and if that sample is already written (the tick is on
+// the first sample of the block, or on the sample a reset cut the trigger at), the new trigger
+// rises one sample late instead. Specialised on the output mode: Replace writes all three
+// spans, Add only the high one (adding 0V is a no-op, so an idle block costs nothing), and an
+// unrouted output only keeps its trigger timing.
+enum OutputWrite
+{
+  kOutputWriteOff,
+  kOutputWriteAdd,
+  kOutputWriteReplace
+};
+
+static const uint8_t kTriggerBits[4] = {
+    nt_grids_port::grids::OUTPUT_BIT_TRIG_1, nt_grids_port::grids::OUTPUT_BIT_TRIG_2,
+    nt_grids_port::grids::OUTPUT_BIT_TRIG_3, nt_grids_port::grids::OUTPUT_BIT_ACCENT};
+static const float kTriggerOnVoltage = 5.0f;
+static const float kTriggerOffVoltage = 0.0f;
 
-  for (int s_cv = 0; s_cv < num_frames_total; ++s_cv)
+template <int kWrite>
+static void render_output(NtGridsAlgorithm *self, int i, float *busFrames, int num_frames_total,
+                          const BlockEvent *events, int num_events)
+{
+  float *out = busFrames + self->output_routes[i].bus_index * num_frames_total;
+  uint32_t remaining = self->trigger_samples_remaining[i];
+  bool last_high = self->trigger_last_high[i]; // The sample before `pos` is high
+  int gap = 0;                                 // Low samples owed before the trigger rises
+  int pos = 0;
+
+  for (int e = 0; e <= num_events; ++e)
   {
-    // Clock Input Detection
-    if (self->v[kParamClockInput] > 0) // Use self->v[] to access parameter value
+    int span_end = (e < num_events) ? events[e].sample_offset : num_frames_total;
+    bool retrigger = e < num_events && (events[e].flags & kEventTick) && (events[e].state & kTriggerBits[i]);
+    int span = span_end - pos;
+    int low_count = (gap < span) ? gap : span; // Leading low samples
+    gap -= low_count;
+    int high_count = span - low_count;
+    if (remaining < (uint32_t)high_count)
     {
-      int clock_bus_array_idx = self->v[kParamClockInput] - 1;
-      if (clock_bus_array_idx < 28) // Max 28 CV buses on Disting EX
-      {
-        float current_sample_clock_cv = busFrames[clock_bus_array_idx * num_frames_total + s_cv];
-        if (current_sample_clock_cv > cv_threshold && self->prev_clock_cv_val <= cv_threshold)
-        {
-          PatternGenerator::TickClock(true);
-          tick_this_step = true; // Local flag for this step's logic
-        }
-        self->prev_clock_cv_val = current_sample_clock_cv;
-      }
-      else
-      {
-        self->prev_clock_cv_val = 0.0f; // Invalid bus selected
-      }
+      high_count = (int)remaining;
+    }
+    remaining -= (uint32_t)high_count;
+    if (retrigger && high_count > 0 && low_count + high_count == span)
+    {
+      high_count--; // Still high at the tick: end a sample early so the new trigger has an edge
+    }
+    if (kWrite == kOutputWriteReplace)
+    {
+      replace_span(out + pos, low_count, kTriggerOffVoltage);
+      replace_span(out + pos + low_count, high_count, kTriggerOnVoltage);
+      replace_span(out + pos + low_count + high_count, span - low_count - high_count, kTriggerOffVoltage);
+    }
+    else if (kWrite == kOutputWriteAdd)
+    {
+      add_span(out + pos + low_count, high_count, kTriggerOnVoltage);
     }
-    else
+    if (span > 0)
     {
-      self->prev_clock_cv_val = 0.0f; // Clock input is 'Off'
+      last_high = high_count > 0 && low_count + high_count == span;
     }
+    pos = span_end;
 
-    // Reset Input Detection
-    if (self->v[kParamResetInput] > 0) // Use self->v[] to access parameter value
+    if (e < num_events)
     {
-      int reset_bus_array_idx = self->v[kParamResetInput] - 1;
-      if (reset_bus_array_idx < 28) // Max 28 CV buses on Disting EX
+      if (events[e].flags & kEventReset)
       {
-        float current_sample_reset_cv = busFrames[reset_bus_array_idx * num_frames_total + s_cv];
-        if (current_sample_reset_cv > cv_threshold && self->prev_reset_cv_val <= cv_threshold)
-        {
-          PatternGenerator::Reset();
-          for (int i = 0; i < 4; ++i)
-          {
-            self->trigger_active_steps_remaining[i] = 0;
-          }
-        }
-        self->prev_reset_cv_val = current_sample_reset_cv;
+        remaining = 0;
       }
-      else
+      if (retrigger)
       {
-        self->prev_reset_cv_val = 0.0f; // Invalid bus selected
+        remaining = self->trigger_length_samples[i];
+        gap = last_high ? 1 : 0; // The sample before is high and already written
       }
     }
-    else
+  }
+  self->trigger_samples_remaining[i] = remaining;
+  self->trigger_last_high[i] = last_high;
+}
+
+static OutputKernel output_kernel(bool enabled, bool replace)
+{
+  if (!enabled)
+    return &render_output<kOutputWriteOff>;
+  return replace ? &render_output<kOutputWriteReplace> : &render_output<kOutputWriteAdd>;
+}
+
+// --- Step kernels ---
+// Rising edges of the routed inputs in one chunk of `count` samples, as hits. With both inputs
+// routed this is the pair scan; with one, the single-bus scan, and the other input is never
+// touched.
+template <bool kClockRouted, bool kResetRouted>
+static int scan_inputs(NtGridsAlgorithm *self, const float *clock_bus, const float *reset_bus, int count,
+                       EdgeScanHit *hits)
+{
+  if (kClockRouted && kResetRouted)
+  {
+    return edge_scan_rising_pair(clock_bus, reset_bus, count, self->clock_edge_config, self->reset_edge_config,
+                                 &self->clock_edge_state, &self->reset_edge_state, hits);
+  }
+  uint16_t offsets[kEdgeScanChunk / 2 + 1];
+  int num_edges = kClockRouted
+                      ? edge_scan_rising(clock_bus, count, self->clock_edge_config, &self->clock_edge_state, offsets)
+                      : edge_scan_rising(reset_bus, count, self->reset_edge_config, &self->reset_edge_state, offsets);
+  for (int k = 0; k < num_edges; ++k)
+  {
+    hits[k].sample_offset = offsets[k];
+    hits[k].inputs = kClockRouted ? kEdgeScanInputA : kEdgeScanInputB;
+  }
+  return num_edges;
+}
+
+// Internal clock ticks in one chunk of `count` samples starting at block offset `base`, merged
+// in sample order with the rising edges of the reset bus (when routed). The accumulator wraps
+// once per tick, so the samples to the next tick are ~phase / increment (the smallest k with
+// phase + (k + 1) * increment past 2^32, less one): one division per tick, nothing per sample. A
+// reset restarts the phase, so the step it lands on lasts a full tick period. A tick on the same
+// sample as a reset goes first, as with the external clock.
+template <bool kResetRouted>
+static int run_internal_clock(NtGridsAlgorithm *self, const float *reset_bus, int base, int count, BlockEvent *events,
+                              int num_events)
+{
+  nt_grids_port::grids::PatternGenerator &generator = self->pattern_generator;
+  uint16_t resets[kEdgeScanChunk / 2 + 1];
+  int num_resets = 0;
+  if (kResetRouted)
+  {
+    num_resets = edge_scan_rising(reset_bus, count, self->reset_edge_config, &self->reset_edge_state, resets);
+  }
+
+  uint32_t phase = self->internal_clock.phase; // Accumulator at the start of sample `pos`
+  const uint32_t increment = self->internal_clock.increment;
+  int pos = 0;
+  for (int r = 0; r <= num_resets; ++r)
+  {
+    int limit = (r < num_resets) ? resets[r] : count - 1; // Last sample whose tick is taken now
+    while (pos <= limit)
+    {
+      uint32_t wait = ~phase / increment;
+      if (wait > (uint32_t)(limit - pos))
+        break;
+      int tick = pos + (int)wait;
+      if (generator.TickClock(true)) // Clocks between steps play nothing
+        num_events = push_block_event(events, num_events, base + tick, generator.get_trigger_state(), kEventTick);
+      phase += (wait + 1) * increment;
+      pos = tick + 1;
+    }
+    if (r < num_resets)
     {
-      self->prev_reset_cv_val = 0.0f; // Reset input is 'Off'
+      generator.Reset();
+      num_events = push_block_event(events, num_events, base + resets[r], generator.get_trigger_state(), kEventReset);
+      phase = 0;
+      pos = resets[r];
     }
-  } // End of CV input processing loop
+  }
+  self->internal_clock.phase = phase + (uint32_t)(count - pos) * increment;
+  return num_events;
+}
 
-  uint8_t current_pattern_state = PatternGenerator::state_;
+// --- External clock tracking ---
+// Intervals longer than this (about 5.8 minutes at 48 kHz) are not measured, which also keeps
+// the 1/16-sample period and timeout x period within 32 bits.
+static const uint32_t kMaxClockInterval = 1u << 24;
 
-  // Trigger Initiation: If a clock ticked in this step, set duration for active pattern bits
-  if (tick_this_step)
+// Folds one measured period into the smoothed estimate. Within half a period of it the
+// measurement is jitter or drift, followed by a one-pole filter taking a quarter of the error.
+// Further out it is a tempo jump or a stray edge: it is only adopted when the next measurement
+// agrees with it to within an eighth.
+static void update_clock_period(ClockTracker &tracker, uint32_t measured_q4)
+{
+  if (tracker.period_q4 == 0)
+  {
+    tracker.period_q4 = measured_q4;
+    return;
+  }
+  uint32_t error = (measured_q4 > tracker.period_q4) ? measured_q4 - tracker.period_q4 : tracker.period_q4 - measured_q4;
+  if (error < tracker.period_q4 / 2)
   {
-    if (current_pattern_state & (1 << 0))
-      self->trigger_active_steps_remaining[0] = NUM_TRIGGER_STEPS;
-    if (current_pattern_state & (1 << 1))
-      self->trigger_active_steps_remaining[1] = NUM_TRIGGER_STEPS;
-    if (current_pattern_state & (1 << 2))
-      self->trigger_active_steps_remaining[2] = NUM_TRIGGER_STEPS;
-    if (current_pattern_state & nt_grids_port::grids::OUTPUT_BIT_ACCENT)
-      self->trigger_active_steps_remaining[3] = NUM_TRIGGER_STEPS;
+    tracker.period_q4 += (int32_t)(measured_q4 - tracker.period_q4) / 4;
+    tracker.candidate_q4 = 0;
+    return;
   }
+  uint32_t mismatch = (measured_q4 > tracker.candidate_q4) ? measured_q4 - tracker.candidate_q4
+                                                           : tracker.candidate_q4 - measured_q4;
+  if (tracker.candidate_q4 != 0 && mismatch < tracker.candidate_q4 / 8)
+  {
+    tracker.period_q4 = measured_q4;
+    tracker.candidate_q4 = 0;
+  }
+  else
+  {
+    tracker.candidate_q4 = measured_q4;
+  }
+}
 
-  // Main processing loop for each sample in the block
-  const float trigger_on_voltage = 5.0f;
-  const float trigger_off_voltage = 0.0f;
+// A real clock edge at block offset `offset`: measures the period and re-locks the freewheel
+// schedule to the edge. Returns whether the edge plays a step. After freewheeling, an edge within
+// half a period of the last freewheeled tick is that tick arriving late, so it only re-locks.
+// The period is only ever measured between real edges: an interval spanning freewheeled ticks
+// is not divided by them, so a clock that slowed down (and was freewheeled over) is measured at
+// its new rate, adopted once a second interval agrees, rather than read back as the old period.
+// An interval spanning a dropout is a one-off jump and is not adopted.
+static bool track_clock_edge(ClockTracker &tracker, int offset)
+{
+  uint32_t now = tracker.block_start + (uint32_t)offset;
+  bool play = true;
+  if (tracker.freewheeling)
+  {
+    play = (now - tracker.anchor) >= (tracker.period_q4 >> 5);
+  }
+  uint32_t interval = now - tracker.last_edge;
+  if (tracker.has_edge && interval < kMaxClockInterval && interval != 0)
+  {
+    update_clock_period(tracker, interval << 4);
+  }
+  tracker.last_edge = now;
+  tracker.anchor = now;
+  tracker.anchor_frac = 0;
+  tracker.freewheeled = 0;
+  tracker.has_edge = true;
+  tracker.freewheeling = false;
+  return play;
+}
 
-  for (int s = 0; s < num_frames_total; ++s)
+// `count` clock input ticks (one edge, or freewheeled steps being caught up) at block offset
+// `offset`, through the multiply/divide stage when kScaled. Divided, only every `divide`-th input
+// plays. Multiplied, sub-ticks still pending from the previous input are caught up first, the
+// input plays one step and `multiply - 1` sub-ticks are scheduled across the tracked period.
+// Before there is a period (the first edge) the sub-ticks cannot be spaced, so they are caught
+// up with the next input instead and the pattern is not left behind. All the steps played here
+// land on one tick event (none if the ticks fall between steps).
+template <bool kScaled>
+static int play_input_ticks(NtGridsAlgorithm *self, int offset, int count, BlockEvent *events, int num_events)
+{
+  nt_grids_port::grids::PatternGenerator &generator = self->pattern_generator;
+  int ticks = count;
+  if (kScaled)
   {
-    for (int i = 0; i < 4; ++i) // Loop through 4 triggers (Trig1, Trig2, Trig3, Accent)
+    ClockScaler &scaler = self->clock_scaler;
+    ticks = scaler.pending + scaler.unspaced;
+    scaler.pending = 0;
+    scaler.unspaced = 0;
+    bool last_played = false;
+    for (int c = 0; c < count; ++c)
+    {
+      last_played = scaler.divide_phase == 0;
+      if (last_played)
+        ticks += (c == count - 1) ? 1 : scaler.multiply;
+      if (++scaler.divide_phase == scaler.divide)
+        scaler.divide_phase = 0;
+    }
+    if (last_played && scaler.multiply > 1)
     {
-      ParameterIndex bus_param_idx;
-      ParameterIndex mode_param_idx;
+      if (self->clock_tracker.period_q4 != 0)
+      {
+        scaler.anchor = self->clock_tracker.block_start + (uint32_t)offset;
+        scaler.step_q4 = self->clock_tracker.period_q4 / scaler.multiply;
+        scaler.index = 0;
+        scaler.pending = scaler.multiply - 1;
+      }
+      else
+      {
+        scaler.unspaced = scaler.multiply - 1; // First edge: nothing to space them by yet
+      }
+    }
+    if (ticks == 0)
+      return num_events;
+  }
+  bool stepped = false;
+  for (int k = 0; k < ticks; ++k)
+  {
+    stepped |= generator.TickClock(true);
+  }
+  if (!stepped) // Clocks between steps play nothing
+    return num_events;
+  return push_block_event(events, num_events, offset, generator.get_trigger_state(), kEventTick);
+}
 
-      // Determine which parameters to use based on the trigger index 'i'
-      switch (i)
+// Scheduled ticks due before block offset `end`, in sample order: multiplied sub-ticks, each on
+// the sample predicted from the input tick and the tracked period, and freewheel ticks. Once
+// `timeout` periods pass without an edge, the steps those periods should have played are caught
+// up in one tick event (the last of them lands on time), then a tick follows every estimated
+// period until an edge returns. A freewheel tick more than a period overdue is not a late tick but
+// a stale anchor, so the schedule restarts from the block start instead of replaying every
+// missed period. Costs a comparison or two when nothing is due.
+template <bool kScaled>
+static int run_clock_schedule(NtGridsAlgorithm *self, int end, BlockEvent *events, int num_events)
+{
+  ClockTracker &tracker = self->clock_tracker;
+  ClockScaler &scaler = self->clock_scaler;
+  const bool freewheel = tracker.timeout != 0 && tracker.has_edge && tracker.period_q4 != 0;
+  if (!freewheel && !(kScaled && scaler.pending != 0))
+    return num_events;
+  for (;;)
+  {
+    int32_t freewheel_offset = INT32_MAX;
+    uint32_t due_q4 = 0;
+    if (freewheel)
+    {
+      due_q4 = tracker.anchor_frac + (tracker.freewheeling ? tracker.period_q4 : tracker.timeout * tracker.period_q4);
+      freewheel_offset = (int32_t)(tracker.anchor + (due_q4 >> 4) - tracker.block_start);
+      if (freewheel_offset < -(int32_t)(tracker.period_q4 >> 4))
       {
-      case 0: // Trig1
-        bus_param_idx = kParamOutputTrig1;
-        mode_param_idx = kParamOutputTrig1Mode;
-        break;
-      case 1: // Trig2
-        bus_param_idx = kParamOutputTrig2;
-        mode_param_idx = kParamOutputTrig2Mode;
-        break;
-      case 2: // Trig3
-        bus_param_idx = kParamOutputTrig3;
-        mode_param_idx = kParamOutputTrig3Mode;
-        break;
-      case 3: // Accent
-        bus_param_idx = kParamOutputAccent;
-        mode_param_idx = kParamOutputAccentMode;
-        break;
-      default: // Should not happen
+        tracker.anchor = tracker.block_start;
+        tracker.anchor_frac = 0;
         continue;
       }
-
-      int bus_idx = self->v[bus_param_idx] - 1; // v is inherited const int16_t*
-      if (bus_idx >= 0 && bus_idx < 28)         // Max 28 buses
+    }
+    if (kScaled && scaler.pending != 0)
+    {
+      uint32_t sub_q4 = (uint32_t)(scaler.index + 1) * scaler.step_q4;
+      int32_t sub_offset = (int32_t)(scaler.anchor + (sub_q4 >> 4) - tracker.block_start);
+      if (sub_offset < freewheel_offset)
       {
-        bool replace_mode = self->v[mode_param_idx];
-        float value_to_write = (self->trigger_active_steps_remaining[i] > 0) ? trigger_on_voltage : trigger_off_voltage;
+        if (sub_offset >= end)
+          break;
+        if (sub_offset < 0) // Due before this block: the multiplier was just raised
+          sub_offset = 0;
+        scaler.index++;
+        scaler.pending--;
+        if (self->pattern_generator.TickClock(true))
+          num_events = push_block_event(events, num_events, sub_offset, self->pattern_generator.get_trigger_state(),
+                                        kEventTick);
+        continue;
+      }
+    }
+    if (freewheel_offset >= end)
+      break;
+    int32_t offset = freewheel_offset;
+    if (offset < 0) // Due before this block: the timeout was just shortened
+      offset = 0;
+    int ticks = tracker.freewheeling ? 1 : tracker.timeout;
+    if (tracker.freewheeled < 0xFFFF - ticks)
+      tracker.freewheeled += ticks;
+    tracker.freewheeling = true;
+    tracker.anchor += due_q4 >> 4;
+    tracker.anchor_frac = (uint8_t)(due_q4 & 15);
+    num_events = play_input_ticks<kScaled>(self, offset, ticks, events, num_events);
+  }
+  return num_events;
+}
 
-        if (replace_mode)
+// One block: clock and reset edges are found by the Schmitt-trigger edge-scan kernel, a chunk
+// at a time so the hit buffer stays a fixed size whatever the block length; each tick or reset
+// is recorded with the state it produced, then every output renders the block through its own
+// kernel. Specialised on the clock source and on whether reset is routed: with no clock and no
+// reset there is nothing to scan, and the internal clock never reads the clock bus.
+template <int kClockSource, bool kResetRouted>
+static void step_kernel(NtGridsAlgorithm *self, float *busFrames, int num_frames_total)
+{
+  const bool kScaled = kClockSource == kClockSourceExternalScaled;
+  const bool kClockRouted = kClockSource == kClockSourceExternal || kScaled;
+  nt_grids_port::grids::PatternGenerator &generator = self->pattern_generator;
+  BlockEvent events[kMaxBlockEvents];
+  int num_events = 0;
+
+  if (kClockSource != kClockSourceNone || kResetRouted)
+  {
+    const float *clock_bus = busFrames + self->clock_bus_index * num_frames_total;
+    const float *reset_bus = busFrames + self->reset_bus_index * num_frames_total;
+    EdgeScanHit hits[kEdgeScanChunk + 2];
+    for (int base = 0; base < num_frames_total; base += kEdgeScanChunk)
+    {
+      int n = num_frames_total - base;
+      if (n > kEdgeScanChunk)
+        n = kEdgeScanChunk;
+      if (kClockSource == kClockSourceInternal)
+      {
+        num_events = run_internal_clock<kResetRouted>(self, reset_bus + base, base, n, events, num_events);
+        continue;
+      }
+      int num_hits = scan_inputs<kClockRouted, kResetRouted>(self, clock_bus + base, reset_bus + base, n, hits);
+      for (int h = 0; h < num_hits; ++h)
+      {
+        int offset = base + hits[h].sample_offset;
+        if (kClockRouted)
+        {
+          num_events = run_clock_schedule<kScaled>(self, offset, events, num_events); // Ticks due before this edge
+        }
+        if ((hits[h].inputs & kEdgeScanInputA) && track_clock_edge(self->clock_tracker, offset))
         {
-          busFrames[bus_idx * num_frames_total + s] = value_to_write;
+          num_events = play_input_ticks<kScaled>(self, offset, 1, events, num_events);
         }
-        else
+        if (hits[h].inputs & kEdgeScanInputB)
         {
-          busFrames[bus_idx * num_frames_total + s] += value_to_write;
+          if (kScaled) // The next played input is `divide` inputs away, as the next step is after a reset
+            self->clock_scaler.divide_phase = (self->clock_scaler.divide > 1) ? 1 : 0;
+          generator.Reset();
+          num_events = push_block_event(events, num_events, offset, generator.get_trigger_state(), kEventReset);
         }
       }
     }
+    if (kClockRouted)
+    {
+      num_events = run_clock_schedule<kScaled>(self, num_frames_total, events, num_events);
+      self->clock_tracker.block_start += (uint32_t)num_frames_total;
+    }
   }
 
-  // Countdown active trigger steps at the end of the block processing
-  for (int i = 0; i < 4; ++i)
+  // Idle blocks take no separate path any more: with no events and no trigger running, the
+  // output kernels reduce to one zero fill per Replace output and nothing for the rest.
+  if (is_idle_block(self, num_events))
   {
-    if (self->trigger_active_steps_remaining[i] > 0)
-    {
-      self->trigger_active_steps_remaining[i]--;
-    }
+    self->idle_blocks_skipped++;
   }
+  for (int i = 0; i < 4; ++i) // Trig1, Trig2, Trig3, Accent
+  {
+    self->output_routes[i].render(self, i, busFrames, num_frames_total, events, num_events);
+  }
+
+  // Spare time, after the outputs are written: evaluate the steps this block consumed (and one
+  // more), so the next ticks only read the lookahead buffer.
+  generator.TopUpLookahead();
+}
+
+static StepKernel step_kernel_for(ClockSource clock_source, bool reset_routed)
+{
+  static const StepKernel kernels[4][2] = {
+      {&step_kernel<kClockSourceNone, false>, &step_kernel<kClockSourceNone, true>},
+      {&step_kernel<kClockSourceExternal, false>, &step_kernel<kClockSourceExternal, true>},
+      {&step_kernel<kClockSourceExternalScaled, false>, &step_kernel<kClockSourceExternalScaled, true>},
+      {&step_kernel<kClockSourceInternal, false>, &step_kernel<kClockSourceInternal, true>}};
+  return kernels[clock_source][reset_routed];
+}
+
+// Original Signature for step: runs the kernel parameterChanged selected.
+static void nt_grids_step(_NT_algorithm *self_base, float *busFrames, int numFramesBy4)
+{
+  NtGridsAlgorithm *self = static_cast<NtGridsAlgorithm *>(self_base); // Use static_cast
+  self->step_kernel(self, busFrames, numFramesBy4 * 4);
 }
 
 // --- Custom UI Callback Implementations (all static as per example) ---
@@ -492,6 +1117,17 @@ static void nt_grids_custom_ui(_NT_algorithm *self_base, const _NT_uiData &data)
   }
 }
 
+// --- Helper: Diagnostic counters, drawn small in the top-left corner ---
+static void draw_status_counters(NtGridsAlgorithm *self, char *buffer)
+{
+  self->m_platform_adapter.drawText(0, 12, "Idle:", 8, kNT_textLeft, kNT_textTiny);
+  self->m_platform_adapter.intToString(buffer, (int32_t)self->idle_blocks_skipped);
+  self->m_platform_adapter.drawText(22, 12, buffer, 8, kNT_textLeft, kNT_textTiny);
+  self->m_platform_adapter.drawText(0, 20, "Rej:", 8, kNT_textLeft, kNT_textTiny);
+  self->m_platform_adapter.intToString(buffer, (int32_t)self->clock_edge_state.rejected_edges);
+  self->m_platform_adapter.drawText(22, 20, buffer, 8, kNT_textLeft, kNT_textTiny);
+}
+
 static bool nt_grids_draw(_NT_algorithm *self_base)
 {
   NtGridsAlgorithm *self = static_cast<NtGridsAlgorithm *>(self_base);
@@ -517,6 +1153,8 @@ static bool nt_grids_draw(_NT_algorithm *self_base)
     self->m_current_mode_strategy->drawModeUI(self, current_y, textSize, line_spacing, buffer);
   }
 
+  draw_status_counters(self, buffer);
+
   return true;
 }
 
@@ -6,8 +6,76 @@
 #include "disting_nt_platform_adapter.h" // Include the new platform adapter
 #include "nt_grids_drum_mode.h"          // Include Drum mode strategy
 #include "nt_grids_euclidean_mode.h"     // Include Euclidean mode strategy
+#include "nt_grids_edge_scan.h"
+#include "nt_grids_pattern_generator.h"
 // IModeStrategy is included by the concrete strategy headers if they are used
 
+struct NtGridsAlgorithm;
+struct BlockEvent; // Clock/reset event within a block, see nt_grids.cc
+
+// --- Step kernels ---
+// Compile-time specialised pieces of the audio path, picked in parameterChanged so that
+// nt_grids_step runs no configuration branches: a step kernel per clock/reset routing and an
+// output kernel per output mode (off, Add, Replace). See nt_grids.cc.
+typedef void (*StepKernel)(NtGridsAlgorithm *self, float *busFrames, int num_frames);
+typedef void (*OutputKernel)(NtGridsAlgorithm *self, int output, float *busFrames, int num_frames,
+                             const BlockEvent *events, int num_events);
+
+// --- Internal clock ---
+// Phase accumulator advanced by `increment` per sample; each wrap is one clock tick. The
+// increment (2^32 x ticks per sample) is set in parameterChanged from the tempo and PPQN.
+struct InternalClock
+{
+  uint32_t phase;
+  uint32_t increment;
+};
+
+// --- External clock tracking ---
+// Smoothed period of the external clock and the freewheel schedule that stands in for it when
+// it goes missing. Sample positions are block-start sample counts plus offsets, compared by
+// wrapping differences; everything is updated per block or per tick, never per sample.
+struct ClockTracker
+{
+  uint32_t block_start;  // Samples processed before this block (wraps)
+  uint32_t last_edge;    // Sample of the last real clock edge (valid when has_edge)
+  uint32_t anchor;       // Last tick, real or freewheeled; the schedule runs from here
+  uint32_t period_q4;    // Smoothed period in 1/16 samples, 0 until two edges were seen
+  uint32_t candidate_q4; // Out-of-range period awaiting a second, matching measurement
+  uint16_t freewheeled;  // Ticks played since last_edge without a clock edge
+  uint8_t anchor_frac;   // Fractional part (1/16 samples) of anchor
+  uint8_t timeout;       // Periods without an edge before freewheeling (0: off), from Clock Timeout
+  bool has_edge;
+  bool freewheeling;
+};
+
+// --- External clock multiply/divide ---
+// Sits between the clock input (or its freewheel) and TickClock. Divided, every `divide`-th
+// input tick plays a step; multiplied, each input plays a step and schedules `multiply - 1`
+// more, spaced by the tracked period / multiply from the input's sample. Only the scaled step
+// kernel touches it, so x1 costs nothing.
+struct ClockScaler
+{
+  uint32_t anchor;      // Sample of the input tick the pending sub-ticks follow
+  uint32_t step_q4;     // Sub-tick spacing in 1/16 samples
+  uint8_t multiply;     // 1, 2, 3, 4, 6, 8, 12 or 24, from Clock Mult/Div
+  uint8_t divide;       // 1 to 4, from Clock Mult/Div
+  uint8_t divide_phase; // Inputs since the last played one, modulo divide
+  uint8_t pending;      // Sub-ticks of the last input still to play
+  uint8_t unspaced;     // Sub-ticks of the last input that had no period to space them; played with the next input
+  uint8_t index;        // Sub-ticks of the last input already played
+};
+
+// --- Output routing table entry ---
+// Built from the output bus/mode parameters in parameterChanged so the audio path never has
+// to decode them. The bus's block offset is bus_index * numFrames.
+struct OutputRoute
+{
+  uint8_t bus_index;   // 0-based bus index (valid only if enabled)
+  bool replace;        // true: Replace, false: Add
+  bool enabled;        // false if the output is 'None' or out of range
+  OutputKernel render; // Writes this output for a block, specialised for enabled/replace
+};
+
 // --- NtGridsAlgorithm Struct Definition ---
 // Moved here from nt_grids.cc so it can be included by other .cc files
 struct NtGridsAlgorithm : _NT_algorithm // Inherit from _NT_algorithm
@@ -15,10 +83,25 @@ struct NtGridsAlgorithm : _NT_algorithm // Inherit from _NT_algorithm
   const float *clock_in;
   const float *reset_in;
 
-  float prev_clock_cv_val;
-  float prev_reset_cv_val;
+  EdgeScanConfig clock_edge_config; // Schmitt thresholds and glitch interval, rebuilt in parameterChanged
+  EdgeScanConfig reset_edge_config; // Same thresholds, no minimum interval
+  EdgeScanState clock_edge_state;   // Also holds the rejected-edge count shown on the UI
+  EdgeScanState reset_edge_state;
+  uint8_t clock_bus_index;          // 0-based clock/reset busses, valid when routed (see step_kernel)
+  uint8_t reset_bus_index;
+  StepKernel step_kernel;           // Specialised for the clock source and reset routing, rebuilt in parameterChanged
+  InternalClock internal_clock;     // Tick source when Clock Source is Internal
+  ClockTracker clock_tracker;       // External clock period and freewheel state
+  ClockScaler clock_scaler;         // External clock multiply/divide stage
+
+  // Pattern state for this instance only; lives in the algorithm's SRAM allocation.
+  nt_grids_port::grids::PatternGenerator pattern_generator;
 
-  int8_t trigger_active_steps_remaining[4]; // Added to track trigger duration over steps
+  uint32_t trigger_samples_remaining[4]; // Samples left on each active trigger (Trig1-3, Accent)
+  bool trigger_last_high[4];             // Last sample of the previous block was high
+  uint32_t trigger_length_samples[4];    // Trigger widths from the length parameters, in samples
+  OutputRoute output_routes[4];          // Trig1-3, Accent routing, rebuilt in parameterChanged
+  uint32_t idle_blocks_skipped;          // Blocks that took the idle fast path (shown on the UI)
 
   // TakeoverPot objects are now defined via the included header
   TakeoverPot m_pots[3];
@@ -0,0 +1,144 @@
+#include "nt_grids_edge_scan.h"
+
+// Bit k for sample k. Selecting from a table instead of shifting by the loop index keeps the
+// packing loops in a form the vectoriser accepts.
+static const uint32_t kSampleBit[kEdgeScanWordSamples] = {
+    1u << 0, 1u << 1, 1u << 2, 1u << 3, 1u << 4, 1u << 5, 1u << 6, 1u << 7,
+    1u << 8, 1u << 9, 1u << 10, 1u << 11, 1u << 12, 1u << 13, 1u << 14, 1u << 15,
+    1u << 16, 1u << 17, 1u << 18, 1u << 19, 1u << 20, 1u << 21, 1u << 22, 1u << 23,
+    1u << 24, 1u << 25, 1u << 26, 1u << 27, 1u << 28, 1u << 29, 1u << 30, 1u << 31};
+
+union FloatBits
+{
+  float f;
+  int32_t i;
+};
+
+uint32_t edge_scan_above_mask_float(const float *in, int count, float threshold)
+{
+  uint32_t mask = 0;
+  if (count == kEdgeScanWordSamples)
+  {
+    for (int k = 0; k < kEdgeScanWordSamples; ++k)
+      mask |= (in[k] > threshold) ? kSampleBit[k] : 0u;
+  }
+  else
+  {
+    for (int k = 0; k < count; ++k)
+      mask |= (in[k] > threshold) ? kSampleBit[k] : 0u;
+  }
+  return mask;
+}
+
+uint32_t edge_scan_above_mask_bits(const float *in, int count, float threshold)
+{
+  FloatBits t;
+  t.f = threshold;
+  uint32_t mask = 0;
+  FloatBits x;
+  if (count == kEdgeScanWordSamples)
+  {
+    for (int k = 0; k < kEdgeScanWordSamples; ++k)
+    {
+      x.f = in[k];
+      mask |= (x.i > t.i) ? kSampleBit[k] : 0u;
+    }
+  }
+  else
+  {
+    for (int k = 0; k < count; ++k)
+    {
+      x.f = in[k];
+      mask |= (x.i > t.i) ? kSampleBit[k] : 0u;
+    }
+  }
+  return mask;
+}
+
+// Drops edges closer than config.min_interval to the previous accepted edge, counting them in
+// state->rejected_edges, and advances the interval counter by one word.
+static uint32_t filter_min_interval(uint32_t rising, int count, const EdgeScanConfig &config, EdgeScanState *state)
+{
+  if (config.min_interval != 0)
+  {
+    uint32_t pending = rising;
+    while (pending)
+    {
+      int offset = __builtin_ctz(pending);
+      uint32_t bit = pending & (0u - pending);
+      pending &= pending - 1;
+      if (state->since_edge + (uint32_t)offset < config.min_interval)
+      {
+        rising &= ~bit;
+        state->rejected_edges++;
+      }
+      else
+      {
+        state->since_edge = 0u - (uint32_t)offset; // Becomes count - offset below
+      }
+    }
+  }
+  state->since_edge += (uint32_t)count;
+  if (state->since_edge > kEdgeScanIntervalCap)
+    state->since_edge = kEdgeScanIntervalCap;
+  return rising;
+}
+
+// Accepted rising edges in the `count` (<= 32) samples at `in`.
+static inline uint32_t scan_word(const float *in, int count, const EdgeScanConfig &config, EdgeScanState *state)
+{
+  uint32_t word_mask = (count == kEdgeScanWordSamples) ? ~0u : ((1u << count) - 1u);
+  uint32_t high = edge_scan_above_mask(in, count, config.high);
+  uint32_t low = (config.low == config.high) ? ~high : ~edge_scan_above_mask(in, count, config.low);
+  uint32_t rising = edge_scan_rising_bits(high, low & word_mask, count, state);
+  return filter_min_interval(rising, count, config, state);
+}
+
+int edge_scan_rising(const float *bus, int count, const EdgeScanConfig &config, EdgeScanState *state,
+                     uint16_t *offsets)
+{
+  int num_edges = 0;
+  for (int base = 0; base < count; base += kEdgeScanWordSamples)
+  {
+    int n = count - base;
+    if (n > kEdgeScanWordSamples)
+      n = kEdgeScanWordSamples;
+    uint32_t rising = scan_word(bus + base, n, config, state);
+    while (rising)
+    {
+      offsets[num_edges++] = (uint16_t)(base + __builtin_ctz(rising));
+      rising &= rising - 1;
+    }
+  }
+  return num_edges;
+}
+
+int edge_scan_rising_pair(const float *bus_a, const float *bus_b, int count, const EdgeScanConfig &config_a,
+                          const EdgeScanConfig &config_b, EdgeScanState *state_a, EdgeScanState *state_b,
+                          EdgeScanHit *hits)
+{
+  if (!bus_a)
+    state_a->above = 0;
+  if (!bus_b)
+    state_b->above = 0;
+
+  int num_hits = 0;
+  for (int base = 0; base < count; base += kEdgeScanWordSamples)
+  {
+    int n = count - base;
+    if (n > kEdgeScanWordSamples)
+      n = kEdgeScanWordSamples;
+    uint32_t rising_a = bus_a ? scan_word(bus_a + base, n, config_a, state_a) : 0;
+    uint32_t rising_b = bus_b ? scan_word(bus_b + base, n, config_b, state_b) : 0;
+    uint32_t rising = rising_a | rising_b;
+    while (rising)
+    {
+      uint32_t bit = rising & (0u - rising);
+      hits[num_hits].sample_offset = (uint16_t)(base + __builtin_ctz(rising));
+      hits[num_hits].inputs = (uint8_t)(((rising_a & bit) ? kEdgeScanInputA : 0) | ((rising_b & bit) ? kEdgeScanInputB : 0));
+      ++num_hits;
+      rising &= rising - 1;
+    }
+  }
+  return num_hits;
+}
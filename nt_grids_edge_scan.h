@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stdint.h>
+
+// --- Rising-edge scan kernel ---
+// Schmitt-trigger edge detection over a CV bus, a 32-sample word at a time. Each word is
+// packed into two bitmasks (bit k set when sample k is above the high threshold / at or below
+// the low threshold); the latch state for every sample is then filled in with a few
+// shift-and-mask steps, rising edges fall out as `state & ~(state << 1 | carry)`, and they are
+// walked with count-trailing-zeros. The packing loops have no branches, so GCC vectorises them
+// on the host; on the Cortex-M7 they compare raw float bits as integers, which avoids the
+// VCMP/VMRS flag transfer per sample. With equal thresholds this is a plain comparator.
+
+static const int kEdgeScanWordSamples = 32;
+
+// Inputs for edge_scan_rising_pair(): bit 0 = input A (clock), bit 1 = input B (reset).
+static const uint8_t kEdgeScanInputA = 1 << 0;
+static const uint8_t kEdgeScanInputB = 1 << 1;
+
+// Per-input detector settings. `low` must not exceed `high`, and both must be >= 0.
+struct EdgeScanConfig
+{
+  float high;            // A sample above this sets the latch
+  float low;             // A sample at or below this clears it
+  uint32_t min_interval; // Edges closer than this many samples to the last accepted edge are rejected (0 = off)
+
+  EdgeScanConfig() : high(0.5f), low(0.5f), min_interval(0) {}
+};
+
+// Per-input state carried across blocks.
+static const uint32_t kEdgeScanIntervalCap = 0x40000000u;
+
+struct EdgeScanState
+{
+  uint32_t above;           // Latch state after the last sample seen (0 or 1)
+  uint32_t since_edge;      // Samples from the last accepted edge to the start of the next block (saturating)
+  uint32_t rejected_edges;  // Edges dropped by min_interval since construction
+
+  EdgeScanState() : above(0), since_edge(kEdgeScanIntervalCap), rejected_edges(0) {}
+};
+
+// One rising edge found by edge_scan_rising_pair().
+struct EdgeScanHit
+{
+  uint16_t sample_offset;
+  uint8_t inputs; // kEdgeScanInputA and/or kEdgeScanInputB
+};
+
+// Pack up to 32 samples into an above-threshold mask (bit k = sample k). A full word runs a
+// fixed-trip loop, which is what lets GCC vectorise it; shorter tails fall back to a plain loop.
+// The float version is the portable one; the bits version compares the IEEE-754 patterns as
+// signed integers, which for a threshold >= 0 orders every non-NaN sample exactly like the
+// float compare (negative samples have the sign bit set and compare below the threshold).
+uint32_t edge_scan_above_mask_float(const float *in, int count, float threshold);
+uint32_t edge_scan_above_mask_bits(const float *in, int count, float threshold);
+
+static inline uint32_t edge_scan_above_mask(const float *in, int count, float threshold)
+{
+#if defined(__arm__)
+  return edge_scan_above_mask_bits(in, count, threshold);
+#else
+  return edge_scan_above_mask_float(in, count, threshold);
+#endif
+}
+
+// Latch state for each sample of a word: the value of the nearest set (`high`) or clear
+// (`low`) bit at or before it, or `carry` where there is none. The masks are disjoint.
+static inline uint32_t edge_scan_schmitt_fill(uint32_t high, uint32_t low, uint32_t carry)
+{
+  uint32_t state = high;
+  uint32_t known = high | low;
+  for (int d = 1; d < kEdgeScanWordSamples; d <<= 1)
+  {
+    state |= (state << d) & ~known;
+    known |= known << d;
+  }
+  return state | (~known & (0u - carry));
+}
+
+// Rising edges in a word of `count` samples (high/low masks from edge_scan_above_mask, low
+// already inverted); updates the carried latch state.
+static inline uint32_t edge_scan_rising_bits(uint32_t high, uint32_t low, int count, EdgeScanState *state)
+{
+  uint32_t latch = edge_scan_schmitt_fill(high, low, state->above);
+  uint32_t rising = latch & ~((latch << 1) | state->above);
+  state->above = (latch >> (count - 1)) & 1u;
+  return rising;
+}
+
+// Scans `count` samples of one bus. Writes the offset of every accepted rising edge to
+// `offsets` (room for count / 2 + 1 entries is always enough) and returns how many were found.
+int edge_scan_rising(const float *bus, int count, const EdgeScanConfig &config, EdgeScanState *state,
+                     uint16_t *offsets);
+
+// Scans two busses in one pass and returns their rising edges merged in sample order; an
+// edge on both inputs at the same sample is one hit with both bits set. Either bus may be
+// null (that input never fires and its latch is forced low). `hits` needs room for
+// count / 2 + 1 entries per non-null bus.
+int edge_scan_rising_pair(const float *bus_a, const float *bus_b, int count, const EdgeScanConfig &config_a,
+                          const EdgeScanConfig &config_b, EdgeScanState *state_a, EdgeScanState *state_b,
+                          EdgeScanHit *hits);
@@ -1,6 +1,6 @@
 #include "nt_grids_euclidean_mode.h"
 #include "nt_grids.h"           // For NtGridsAlgorithm, ParameterIndex, etc.
-#include "nt_grids_resources.h" // For nt_grids_port::lut_res_euclidean and LUT_RES_EUCLIDEAN_SIZE
+#include "nt_grids_resources.h" // For nt_grids_port::kNumParts
 #include <cstring>
 #include <cstdio> // For snprintf
 
@@ -351,7 +351,7 @@ void EuclideanModeStrategy::determinePotConfig(NtGridsAlgorithm *self, int pot_i
     break;
   }
 
-  primary_scale = 16.0f; // All Euclidean Length/Fill params have max 16
+  primary_scale = 32.0f; // All Euclidean Length/Fill params have max 32
 
   // In Euclidean mode, pots don't use button-toggled alternate parameters in the same way as Drum mode's Chaos.
   // The "alternate" function (Length vs Fill) is a mode-wide toggle for all three pots.
@@ -0,0 +1,81 @@
+#include "nt_grids_euclidean_pattern.h"
+
+namespace nt_grids_port
+{
+
+  uint32_t EuclideanPattern(uint8_t num_steps, uint8_t num_notes)
+  {
+    if (num_steps > 32)
+      num_steps = 32;
+    if (num_notes > num_steps)
+      num_notes = num_steps;
+
+    // Start with num_notes groups "1" followed by the rest as "0". Each pass appends one of the
+    // trailing groups to each of the first k groups, until no remainder is left.
+    uint32_t bits[32];
+    uint8_t lengths[32];
+    int num_groups = num_steps;
+    for (int i = 0; i < num_groups; ++i)
+    {
+      bits[i] = (i < num_notes) ? 1u : 0u;
+      lengths[i] = 1;
+    }
+
+    int k = num_notes;
+    while (k > 0)
+    {
+      int cut = num_groups - k;
+      if (cut > k)
+        cut = k;
+      // New sequence: [g[i] + g[k + i] for i < cut] + g[cut:k] + g[k + cut:]
+      for (int i = 0; i < cut; ++i)
+      {
+        bits[i] |= bits[k + i] << lengths[i];
+        lengths[i] += lengths[k + i];
+      }
+      int out = k; // g[cut:k] stays in place at cut..k-1
+      for (int i = k + cut; i < num_groups; ++i)
+      {
+        bits[out - (k - cut)] = bits[i];
+        lengths[out - (k - cut)] = lengths[i];
+        ++out;
+      }
+      num_groups -= cut;
+      k = cut;
+    }
+
+    uint32_t mask = 0;
+    int position = 0;
+    for (int i = 0; i < num_groups; ++i)
+    {
+      mask |= bits[i] << position;
+      position += lengths[i];
+    }
+    return mask;
+  }
+
+  uint32_t EuclideanTableMask(uint8_t length, uint8_t density)
+  {
+    if (length < 1)
+      length = 1;
+    if (length > 32)
+      length = 32;
+    if (density > 31)
+      density = 31;
+
+    // The table in this port lost two entries from the length-2 row (a run of identical
+    // values, somewhere after index 39), so from there on every entry sits two places early
+    // and the last two are zero. Reproduce that so existing patches play the same.
+    int address = (length - 1) * 32 + density;
+    if (address >= 40)
+      address += 2;
+    if (address >= 1024)
+      return 0;
+
+    int table_length = address / 32 + 1;
+    int table_density = address % 32;
+    int num_notes = (table_density * table_length + 15) / 31; // round(density * length / 31)
+    return EuclideanPattern((uint8_t)table_length, (uint8_t)num_notes);
+  }
+
+} // namespace nt_grids_port
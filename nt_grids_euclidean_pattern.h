@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace nt_grids_port
+{
+
+  // --- Euclidean pattern generation ---
+  // Computes the masks that used to be read from the 4 KB lut_res_euclidean table. Bit i of a
+  // mask is step i. Cheap enough to run on parameter changes; PatternGenerator caches the
+  // result per part.
+
+  // Bjorklund's algorithm: `num_notes` onsets spread as evenly as possible over `num_steps`
+  // (1-32) steps, in the grouping order used to generate the original Grids table.
+  uint32_t EuclideanPattern(uint8_t num_steps, uint8_t num_notes);
+
+  // The mask the table held for `length` (1-32) and `density` (0-31): Bjorklund with
+  // round(density * length / 31) notes, reproduced bit for bit including the table's two
+  // missing entries (see the .cc). PatternGenerator does not use it: its Fill is the number of
+  // notes at every length, where the table's density scaled with the length and broke down
+  // beyond 16 steps.
+  uint32_t EuclideanTableMask(uint8_t length, uint8_t density);
+
+} // namespace nt_grids_port
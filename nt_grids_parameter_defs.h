@@ -37,6 +37,28 @@ enum ParameterIndex
   kParamOutputTrig3Mode,
   kParamOutputAccent,
   kParamOutputAccentMode,
+  // Trigger shaping
+  kParamTrig1Length,
+  kParamTrig2Length,
+  kParamTrig3Length,
+  kParamAccentLength,
+  // Clock input conditioning
+  kParamClockHigh,
+  kParamClockLow,
+  kParamClockMinInterval,
+  // Chaos
+  kParamChaosSeed,
+  // Drum Mode Specific (added later, kept at the end so saved presets keep their indices)
+  kParamDrumLength,
+  // Internal clock
+  kParamClockSource,
+  kParamTempo,
+  // Clock loss
+  kParamClockTimeout,
+  // Clock multiply/divide
+  kParamClockScale,
+  // Clock resolution (steps per clock tick)
+  kParamClockResolution,
   kNumParameters // Represents the total number of parameters
 };
 
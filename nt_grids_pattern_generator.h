@@ -51,16 +51,19 @@ namespace nt_grids_port
       uint8_t chaos_amount; // Chaos amount for Euclidean patterns
     };
 
-    struct PatternGeneratorSettings
+    template <uint8_t kParts>
+    struct BasicPatternGeneratorSettings
     {
       union Options
       {
         DrumsSettings drums;
         EuclideanSettings euclidean; // Use the new struct for Euclidean options
       } options;
-      uint8_t density[kNumParts]; // kNumParts is from nt_grids_resources.h
+      uint8_t density[kParts];
     };
 
+    typedef BasicPatternGeneratorSettings<kNumParts> PatternGeneratorSettings; // kNumParts is from nt_grids_resources.h
+
     enum OutputMode
     {
       OUTPUT_MODE_EUCLIDEAN,
@@ -75,6 +78,10 @@ namespace nt_grids_port
       CLOCK_RESOLUTION_LAST
     };
 
+    // 24 PPQN pulses one clock tick stands for, per resolution (as the original Grids' tick
+    // granularity): a 4 PPQN tick plays two steps, an 8 PPQN tick one, a 24 PPQN tick a third.
+    const uint8_t kPulsesPerTick[CLOCK_RESOLUTION_LAST] = {6, 3, 1};
+
     // OutputBits might not be directly used in the Disting NT context
     // but kept for porting completeness of the Options struct.
     enum OutputBits
@@ -128,36 +135,103 @@ namespace nt_grids_port
       }
     };
 
-    class PatternGenerator
+    const uint8_t kLookaheadSteps = 16; // Power of two
+
+    // Step masks hold one bit per main step: 32 bits up to 32 steps, 64 above.
+    template <uint8_t kSteps>
+    struct StepMaskTraits
+    {
+      typedef uint32_t Type;
+    };
+
+    template <>
+    struct StepMaskTraits<64>
+    {
+      typedef uint64_t Type;
+    };
+
+    // Pattern generator for kParts trigger outputs over a kSteps-step sequence. Both are
+    // compile-time constants so the per-part and per-step loops have fixed trip counts and the
+    // step masks are sized to fit. The plugin uses PatternGenerator (3 parts, 32 steps, see the
+    // typedef below); the member definitions live in nt_grids_pattern_generator_impl.h.
+    template <uint8_t kParts, uint8_t kSteps>
+    class BasicPatternGenerator
     {
     public:
-      PatternGenerator() {} // Non-static constructor
-      ~PatternGenerator() {}
+      // Shadow the namespace constants, so the code below is written once for any variant.
+      static const uint8_t kNumParts = kParts;
+      static const uint8_t kStepsPerPattern = kSteps;
 
-      static const uint8_t kOriginalGridsPulsesPerStep = 3; // For original Grids clocking mode (24PPQN / 8th note = 3)
+      static_assert(kParts >= 1 && kParts <= 7, "Trigger bits and the accent bit share a uint8_t state");
+      static_assert(kSteps >= 8 && kSteps <= 64 && (kSteps & (kSteps - 1)) == 0,
+                    "Steps per pattern must be a power of two from 8 to 64");
+
+      typedef typename StepMaskTraits<kSteps>::Type StepMask;
 
-      static void Init();      // Initializes with default settings
-      static void Reset();     // Resets pattern to the beginning
-      static void Retrigger(); // Re-evaluates and outputs the current step's triggers
+      // Sequence position of one main step: everything besides the settings that decides what
+      // the step plays.
+      struct StepPosition
+      {
+        uint32_t bar;                      // Passes through the kSteps-step sequence since Reset
+        uint8_t step;                      // Main step, 0 to kSteps-1
+        uint8_t euclidean_step[kNumParts]; // Per-part Euclidean step, 0 to length-1
+      };
+
+      // One precomputed upcoming step (see FillLookahead).
+      struct LookaheadEntry
+      {
+        uint32_t bar;
+        uint8_t step;
+        uint8_t state; // Trigger/accent bits, as get_trigger_state() will return them
+      };
 
-      // Advances the pattern based on an external clock tick.
-      // Behavior depends on `original_grids_clocking` option.
-      static void TickClock(bool external_clock_tick);
+      BasicPatternGenerator() { Init(); }
+      ~BasicPatternGenerator() {}
 
-      static uint8_t step() { return step_; } // Current step in the main 32-step sequence (0-31)
+      static const uint8_t kOriginalGridsPulsesPerStep = 3; // For original Grids clocking mode (24PPQN / 8th note = 3)
+
+      void Init();      // Initializes with default settings
+      void Reset();     // Resets pattern to the beginning
+      // Jumps to main step `step` (0 to pattern_length()-1) of `bar`, exactly as if Reset had been
+      // followed by the clock ticks leading there with the current lengths and clocking mode, and
+      // evaluates it. Constant-time: no ticks are replayed. Seek(0, 0) is Reset().
+      void Seek(uint32_t bar, uint8_t step);
+      void Retrigger(); // Re-evaluates and outputs the current step's triggers
+
+      // Advances the pattern based on an external clock tick, by kPulsesPerTick of the clock
+      // resolution (24 PPQN ticks in original Grids clocking) over kPulsesPerStep per step.
+      // Returns whether a step was played; ticks between steps (below 8 PPQN) play nothing.
+      bool TickClock(bool external_clock_tick);
+
+      uint8_t step() const { return step_; } // Current step in the main sequence (0 to kSteps-1)
+      uint32_t bar() const { return bar_; }  // Completed passes through the main sequence since Reset
+      // Randomness added to `part`'s drum-map levels in the current bar (Drum mode chaos).
+      uint8_t part_perturbation(uint8_t part) const { return DrumPerturbation(bar_, part); }
+
+      // Chaos seed. Chaos is a pure function of (seed, bar, step, part): the same seed replays
+      // the same variations from a reset.
+      void set_seed(uint32_t seed)
+      {
+        random_.Seed(seed);
+        euclidean_chaos_valid_[0] = euclidean_chaos_valid_[1] = false;
+        InvalidateLookahead();
+      }
+      uint32_t seed() const { return random_.seed(); }
 
       // --- Option Accessors & Mutators --- Tied to Disting NT parameters
-      static bool output_clock_active() { return options_.output_clock; }
-      static bool gate_mode_active() { return options_.gate_mode; }
-      static OutputMode current_output_mode() { return options_.output_mode; }
-      static ClockResolution current_clock_resolution() { return options_.clock_resolution; }
+      bool output_clock_active() const { return options_.output_clock; }
+      bool gate_mode_active() const { return options_.gate_mode; }
+      OutputMode current_output_mode() const { return options_.output_mode; }
+      ClockResolution current_clock_resolution() const { return options_.clock_resolution; }
 
-      static void set_output_clock_active(bool active) { options_.output_clock = active; }
-      static void set_output_mode(OutputMode mode)
+      void set_output_clock_active(bool active) { options_.output_clock = active; }
+      void set_output_mode(OutputMode mode)
       {
         options_.output_mode = mode;
+        InvalidateLookahead();
       }
-      static void set_clock_resolution(ClockResolution resolution)
+      // Takes effect from the next tick; the position and the pulses towards the next step are kept.
+      void set_clock_resolution(ClockResolution resolution)
       {
         if (resolution >= CLOCK_RESOLUTION_LAST)
         {
@@ -165,69 +239,210 @@ namespace nt_grids_port
         }
         options_.clock_resolution = resolution;
       }
-      static void set_gate_mode(bool active) { options_.gate_mode = active; }
-      static void set_original_grids_clocking(bool enabled);
+      void set_gate_mode(bool active) { options_.gate_mode = active; }
+      void set_original_grids_clocking(bool enabled);
 
       // Manages pulse durations for trigger outputs
-      static void IncrementPulseCounter();
+      void IncrementPulseCounter();
 
-      static PatternGeneratorSettings settings_[2]; // Index 0 for Euclidean, 1 for Drums
-      static Options options_;
-      static bool chaos_globally_enabled_; // Master switch for chaos effects
-      static void set_global_chaos(bool enabled) { chaos_globally_enabled_ = enabled; }
+      BasicPatternGeneratorSettings<kParts> settings_[2]; // Index 0 for Euclidean, 1 for Drums
+      Options options_;
+      bool chaos_globally_enabled_; // Master switch for chaos effects
+      void set_global_chaos(bool enabled)
+      {
+        chaos_globally_enabled_ = enabled;
+        InvalidateLookahead();
+      }
 
       // Provides the current trigger state for all parts (and accent).
       // Bit 0: Part 1 (BD/EUC1), Bit 1: Part 2 (SD/EUC2), Bit 2: Part 3 (HH/EUC3)
-      // Bit 3: Accent (in Drum mode or chaotic Euclidean)
-      static uint8_t get_trigger_state() { return state_; }
+      // Bit 3: Accent (in Drum mode or chaotic Euclidean); bit kParts in general
+      uint8_t get_trigger_state() const { return state_; }
 
       // --- Status Info ---
-      static bool on_first_beat() { return first_beat_; }
-      static bool on_beat() { return beat_; }
+      bool on_first_beat() const { return first_beat_; }
+      bool on_beat() const { return beat_; }
+
+      // Rebuilds the drum rank tables if drums.x/y changed since the last call. Call after
+      // writing the drum settings so the (expensive, data-dependent) rebuild happens at control
+      // rate; Evaluate only repeats the check as a fallback.
+      void PrepareDrumLevels();
+
+      // Rebuilds this bar's Euclidean chaos masks if the bar, the effective chaos amount or the
+      // seed changed since the last call. EvaluateEuclidean calls it, so the rebuild runs once
+      // per bar (or on a chaos change) and every other step is bit tests only.
+      void PrepareEuclideanChaos() { PrepareEuclideanChaos(bar_); }
+
+      // --- Lookahead ---
+      // Up to kLookaheadSteps upcoming steps, evaluated ahead of time into a ring buffer.
+      // FillLookahead tops it up, evaluating at most `max_steps` new entries; TickClock then
+      // takes the next step's state from the buffer instead of evaluating at the tick.
+      // TopUpLookahead evaluates one more step than the ticks consumed since the last fill, so
+      // a full buffer stays full and one invalidated on every block (a density under CV) costs
+      // about the steps played rather than a whole refill. Readers such as the display can peek
+      // at upcoming steps without touching the sequence. The setters invalidate the buffer; code
+      // that writes settings_ directly must call InvalidateLookahead itself.
+      void FillLookahead(uint8_t max_steps = kLookaheadSteps);
+      void TopUpLookahead() { FillLookahead(lookahead_consumed_ + 1); }
+      void InvalidateLookahead() { lookahead_count_ = 0; }
+      uint8_t lookahead_count() const { return lookahead_count_; }
+      const LookaheadEntry &lookahead(uint8_t k) const // k = 0 is the next step; k < lookahead_count()
+      {
+        return lookahead_[(lookahead_head_ + k) & (kLookaheadSteps - 1)];
+      }
+
+      StepPosition position() const;                           // Position of the current step
+      StepPosition PositionAt(uint32_t bar, uint8_t step) const; // Position Seek(bar, step) goes to
+
+      // --- Bulk rendering ---
+      // Writes the states of `count` consecutive main steps, starting with the one at `start`, to
+      // `states` (bits as get_trigger_state()), for the current settings. With `levels`, also
+      // writes each part's level per step: in drum mode the drum-map level plus the bar's
+      // perturbation (saturated at 255), the value the density threshold is applied to; in
+      // Euclidean mode 255 on a pattern hit and 0 otherwise, before chaos. Writes nothing but
+      // `states` and `levels`: the chaos masks are built per bar into locals, and so are the drum
+      // rank tables if they are stale, so it is safe to call from any reader.
+      void RenderSteps(const StepPosition &start, uint16_t count, uint8_t *states,
+                       uint8_t (*levels)[kNumParts] = nullptr) const;
 
       // --- Euclidean Parameter Setters ---
-      static void SetLength(uint8_t channel, uint8_t length);
-      static void SetFill(uint8_t channel, uint8_t fill_param_value); // fill_param_value is 0-255 from UI
+      void SetLength(uint8_t channel, uint8_t length);
+      void SetFill(uint8_t channel, uint8_t fill_param_value); // fill_param_value is 0-255 from UI
+      void SetShift(uint8_t channel, uint8_t shift);           // Rotation in steps; wraps at the length
+
+      // Main sequence length in steps (1 to kSteps, default kSteps): the bar wraps after this
+      // many steps, e.g. 24 for 3/4 or 28 for 7/8. Beats and the first beat follow it.
+      void SetPatternLength(uint8_t length);
+      uint8_t pattern_length() const { return pattern_length_; }
 
       // --- Internal State Variables ---
-      static uint8_t output_buffer_[kStepsPerPattern >> 3]; // Stores the full pattern bitmask (not directly used for real-time state_)
-      static uint8_t pulse_counter_[kNumParts];             // Tracks individual part pulse counts (if ever needed)
-      static uint8_t pulse_duration_[kNumParts];            // Individual pulse durations (if ever needed, currently global via state_)
-      static uint8_t current_euclidean_length_[kNumParts];  // Active length for each Euclidean part
-      static uint8_t fill_[kNumParts];                      // Calculated number of active steps for Euclidean parts, based on density
-      static uint8_t step_counter_[kNumParts];              // Generic step counter per part, used for Euclidean perturbation in original code
-      static uint8_t part_perturbation_[kNumParts];         // Randomness value applied per part in Drum mode
-      static uint8_t euclidean_step_[kNumParts];            // Current step for each Euclidean generator (0 to length-1)
-
-      static uint8_t state_; // Holds the current trigger/accent state for the current tick for all parts + accent.
-      static uint8_t step_;  // Current step in the main 32-step sequence (0-31), synonymous with sequence_step_
+      uint8_t output_buffer_[kStepsPerPattern >> 3]; // Stores the full pattern bitmask (not directly used for real-time state_)
+      uint8_t pulse_counter_[kNumParts];             // Tracks individual part pulse counts (if ever needed)
+      uint8_t pulse_duration_[kNumParts];            // Individual pulse durations (if ever needed, currently global via state_)
+      uint8_t current_euclidean_length_[kNumParts];  // Active length for each Euclidean part
+      uint8_t fill_[kNumParts];                      // Calculated number of active steps for Euclidean parts, based on density
+      uint8_t step_counter_[kNumParts];              // Generic step counter per part, used for Euclidean perturbation in original code
+      uint8_t euclidean_step_[kNumParts];            // Current step for each Euclidean generator (0 to length-1)
+      uint8_t euclidean_shift_[kNumParts];           // Rotation applied to each Euclidean pattern (steps)
+      uint32_t euclidean_mask_[kNumParts];           // Rotated pattern for the current length/fill/shift, bit i = step i
+
+      uint8_t state_; // Holds the current trigger/accent state for the current tick for all parts + accent.
+      uint8_t step_;  // Current step in the main 32-step sequence (0-31), synonymous with sequence_step_
+      uint32_t bar_;  // Bar counter (wraps of sequence_step_), the chaos position together with step_
 
       // Clock and timing related
-      static uint16_t internal_clock_ticks_; // Counts sub-ticks for original Grids clocking mode.
-      static uint8_t beat_counter_;          // Counts beats (e.g., quarter notes based on sequence_step_).
-      static uint8_t sequence_step_;         // Current step in the sequence (0-31), drives pattern evaluation.
-      static bool swing_applied_;            // Tracks if swing has been applied in the current sub-step (more relevant to original complex swing).
-      static bool first_beat_;               // True if current step is the first beat of the pattern.
-      static bool beat_;                     // True if current step is on a beat (typically quarter note).
+      uint16_t internal_clock_ticks_; // 24 PPQN pulses towards the next step (0 to kPulsesPerStep-1)
+      uint8_t beat_counter_;          // Counts beats (e.g., quarter notes based on sequence_step_).
+      uint8_t sequence_step_;         // Current step in the sequence (0-31), drives pattern evaluation.
+      bool swing_applied_;            // Tracks if swing has been applied in the current sub-step (more relevant to original complex swing).
+      bool first_beat_;               // True if current step is the first beat of the pattern.
+      bool beat_;                     // True if current step is on a beat (typically quarter note).
+      uint8_t pattern_length_;        // Steps per bar, see SetPatternLength
+      StepMask beat_mask_;            // Bit s set when step s is on a beat, for the current length
 
-    private:
-      static void Evaluate();
-      static void EvaluateEuclidean();
-      static void EvaluateDrums();
+      Random random_; // Chaos source (seeded hash), private to this generator
 
-      static uint8_t ReadDrumMap(
+    private:
+      // Drum rank tables for one x/y, see the drum pattern cache below
+      struct DrumLevels
+      {
+        uint8_t sorted_levels[kNumParts][kStepsPerPattern];
+        StepMask rank_masks[kNumParts][kStepsPerPattern];
+      };
+
+      void Evaluate();
+      // State of the step at `position` for the current settings. Touches only the caches, never
+      // the sequence position, so it serves the current step and the lookahead alike.
+      uint8_t EvaluateAt(const StepPosition &position);
+      uint8_t EvaluateEuclidean(const StepPosition &position);
+      uint8_t EvaluateDrums(const StepPosition &position);
+      uint8_t DrumPerturbation(uint32_t bar, uint8_t part) const;
+      void DrumMasks(uint32_t bar, const DrumLevels &drum_levels, uint8_t *perturbation, StepMask *trigger_masks,
+                     StepMask *accent_masks) const;
+      static uint8_t DrumState(uint8_t step, const StepMask *trigger_masks, const StepMask *accent_masks);
+      void AdvancePosition(StepPosition &position) const; // One main step, as TickClock advances
+      void PrepareEuclideanChaos(uint32_t bar);
+      void EuclideanChaosMasks(uint32_t bar, StepMask *flip_masks, StepMask *accent_masks) const;
+      uint8_t EuclideanState(const StepPosition &position, const StepMask *flip_masks,
+                             const StepMask *accent_masks) const;
+      void UpdateEuclideanMask(uint8_t channel); // Recomputes euclidean_mask_ after a length/fill/shift change
+
+      uint8_t ReadDrumMap(
           uint8_t step,
           uint8_t instrument,
           uint8_t x,
-          uint8_t y);
+          uint8_t y) const;
+
+      // --- Drum pattern cache ---
+      // Per-part rank tables, rebuilt only when x/y change (PrepareDrumLevels, called from the
+      // parameter path). Each part's kSteps steps are ordered by interpolated drum-map level
+      // (highest first); sorted_levels holds the levels in that order and rank_masks[p][k] the
+      // mask of the top k + 1 steps. Density and perturbation only move a threshold over the
+      // levels, so EvaluateDrums selects the trigger and accent masks as rank prefixes (a
+      // fixed-length search) and then does a bit test per part.
+      void BuildDrumLevels(uint8_t x, uint8_t y, DrumLevels &drum_levels) const;
+      // drum_levels_ if it was built for the current x/y, otherwise the tables built into `scratch`
+      const DrumLevels &CurrentDrumLevels(DrumLevels &scratch) const;
+      static StepMask DrumRankMask(const DrumLevels &drum_levels, uint8_t part, int level_threshold);
+
+      DrumLevels drum_levels_;
+      uint8_t cached_x_;
+      uint8_t cached_y_;
+      bool drum_levels_valid_;
+
+      // --- Euclidean chaos cache ---
+      // Per-part masks over the steps of the current bar: euclidean_flip_mask_ inverts the
+      // pattern bit, euclidean_accent_mask_ adds an accent. Each bit is set independently with
+      // the probability the per-step draws used to have: flip = amount / 2048 (gate
+      // amount / 256, then 1 in 8), accent = amount / 4096 above 192 (gate, then 1 in 16).
+      // Built from random words by the binary expansion of the probability (see
+      // BernoulliMask), so the probabilities are exact.
+      // Two slots, indexed by bar & 1, so the lookahead can run into the next bar without
+      // rebuilding the current one. RenderSteps builds its own (EuclideanChaosMasks) instead.
+      StepMask BernoulliMask(uint32_t numerator, uint8_t denominator_bits, uint32_t bar, uint8_t part,
+                             uint8_t stream) const;
+      // One random word per step mask; 64-step variants join two draws (high half on stream | 0x80).
+      StepMask RandomMask(uint32_t bar, uint8_t digit, uint8_t part, uint8_t stream) const
+      {
+        StepMask word = random_.GetWord(bar, digit, part, stream);
+        if (sizeof(StepMask) > sizeof(uint32_t))
+        {
+          word |= ((StepMask)random_.GetWord(bar, digit, part, stream | 0x80) << 16) << 16;
+        }
+        return word;
+      }
+
+      StepMask euclidean_flip_mask_[2][kNumParts];
+      StepMask euclidean_accent_mask_[2][kNumParts];
+      uint32_t euclidean_chaos_bar_[2];
+      uint8_t euclidean_chaos_amount_[2]; // Effective amount the masks were built for (0 = chaos off)
+      bool euclidean_chaos_valid_[2];
+
+      // --- Lookahead ring buffer ---
+      LookaheadEntry lookahead_[kLookaheadSteps];
+      StepPosition lookahead_tail_; // Position of the newest entry
+      uint8_t lookahead_head_;
+      uint8_t lookahead_count_;
+      uint8_t lookahead_consumed_; // Steps ticked since the last fill, saturating at kLookaheadSteps
 
       // State variables
-      static uint8_t pulse_;
-      static uint16_t pulse_duration_counter_;
+      uint8_t pulse_;
+      uint16_t pulse_duration_counter_;
 
-      DISALLOW_COPY_AND_ASSIGN(PatternGenerator); // From nt_grids_utils.h
+      DISALLOW_COPY_AND_ASSIGN(BasicPatternGenerator); // From nt_grids_utils.h
     };
 
+    template <uint8_t kParts, uint8_t kSteps>
+    const uint8_t BasicPatternGenerator<kParts, kSteps>::kNumParts;
+    template <uint8_t kParts, uint8_t kSteps>
+    const uint8_t BasicPatternGenerator<kParts, kSteps>::kStepsPerPattern;
+    template <uint8_t kParts, uint8_t kSteps>
+    const uint8_t BasicPatternGenerator<kParts, kSteps>::kOriginalGridsPulsesPerStep;
+
+    typedef BasicPatternGenerator<kNumParts, kStepsPerPattern> PatternGenerator; // Instantiated in nt_grids_pattern_generator.cc
+    typedef PatternGenerator::StepPosition StepPosition;
+    typedef PatternGenerator::LookaheadEntry LookaheadEntry;
+
   } // namespace grids
 } // namespace nt_grids_port
 
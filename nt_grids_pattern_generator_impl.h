@@ -0,0 +1,767 @@
+// Copyright (C) 2012 Emilie Gillet.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+// Based on the original Grids by Emilie Gillet.
+
+// Member definitions of BasicPatternGenerator. nt_grids_pattern_generator.cc instantiates the
+// plugin's 3-part, 32-step PatternGenerator; include this header only to instantiate another
+// (parts, steps) variant.
+
+#ifndef NT_GRIDS_PATTERN_GENERATOR_IMPL_H_
+#define NT_GRIDS_PATTERN_GENERATOR_IMPL_H_
+
+#include "nt_grids_pattern_generator.h"
+#include "nt_grids_utils.h"     // For Random, U8Mix etc.
+#include "nt_grids_resources.h" // For DrumMapAccess
+#include "nt_grids_euclidean_pattern.h"
+
+#include <algorithm> // For std::min, std::max if needed
+
+namespace nt_grids_port
+{
+  namespace grids
+  {
+
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::Init()
+    {
+      std::memset(settings_, 0, sizeof(settings_));
+      std::memset(&options_, 0, sizeof(options_));
+      std::memset(output_buffer_, 0, sizeof(output_buffer_));
+      std::memset(pulse_counter_, 0, sizeof(pulse_counter_));
+      std::memset(pulse_duration_, 0, sizeof(pulse_duration_));
+      std::memset(current_euclidean_length_, 0, sizeof(current_euclidean_length_));
+      std::memset(fill_, 0, sizeof(fill_));
+      std::memset(step_counter_, 0, sizeof(step_counter_));
+      std::memset(euclidean_step_, 0, sizeof(euclidean_step_));
+      std::memset(euclidean_shift_, 0, sizeof(euclidean_shift_));
+      std::memset(euclidean_mask_, 0, sizeof(euclidean_mask_));
+      random_.Init();
+      drum_levels_valid_ = false;
+      std::memset(euclidean_flip_mask_, 0, sizeof(euclidean_flip_mask_));
+      std::memset(euclidean_accent_mask_, 0, sizeof(euclidean_accent_mask_));
+      std::memset(euclidean_chaos_bar_, 0, sizeof(euclidean_chaos_bar_));
+      std::memset(euclidean_chaos_amount_, 0, sizeof(euclidean_chaos_amount_));
+      euclidean_chaos_valid_[0] = euclidean_chaos_valid_[1] = false;
+      std::memset(lookahead_, 0, sizeof(lookahead_));
+      std::memset(&lookahead_tail_, 0, sizeof(lookahead_tail_));
+      lookahead_head_ = 0;
+      lookahead_count_ = 0;
+      lookahead_consumed_ = 0;
+
+      options_.output_mode = OUTPUT_MODE_DRUMS; // Corrected
+      state_ = 0;
+      beat_counter_ = 0;
+      sequence_step_ = 0;
+      internal_clock_ticks_ = 0;
+      swing_applied_ = false;
+      step_ = 0; // Ensure step_ (if different from sequence_step_) is also init
+      bar_ = 0;
+      pulse_ = 0;
+      pulse_duration_counter_ = 0;
+      first_beat_ = true; // Initialize these as well
+      beat_ = true;
+      SetPatternLength(kStepsPerPattern);
+
+      options_.original_grids_clocking = false; // Default: external clock directly drives main steps
+      chaos_globally_enabled_ = false;
+
+      options_.clock_resolution = CLOCK_RESOLUTION_8_PPQN; // One step per tick, as direct clocking always played
+      options_.output_clock = false;
+      options_.gate_mode = false;
+
+      // Default settings for Drum mode
+      settings_[OUTPUT_MODE_DRUMS].options.drums.x = 128;        // Center of map
+      settings_[OUTPUT_MODE_DRUMS].options.drums.y = 128;        // Center of map
+      settings_[OUTPUT_MODE_DRUMS].options.drums.randomness = 0; // No chaos initially
+      for (int i = 0; i < kNumParts; ++i)
+      {
+        settings_[OUTPUT_MODE_DRUMS].density[i] = 255; // Full density BD/SD/HH
+      }
+
+      // Default settings for Euclidean mode
+      settings_[OUTPUT_MODE_EUCLIDEAN].options.euclidean.chaos_amount = 0; // No chaos initially
+      for (int i = 0; i < kNumParts; ++i)
+      {
+        current_euclidean_length_[i] = 16;                 // Default length: 16 steps
+        fill_[i] = 8;                                      // Default fill: 8 steps (50% for a 16-step length)
+        settings_[OUTPUT_MODE_EUCLIDEAN].density[i] = 128; // Density 128/255 maps to ~8 steps for a 16-step length
+        UpdateEuclideanMask(i);
+      }
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::Reset()
+    {
+      Seek(0, 0);
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::Seek(uint32_t bar, uint8_t step)
+    {
+      StepPosition target = PositionAt(bar, step);
+      bar_ = target.bar;
+      sequence_step_ = target.step;
+      step_ = target.step;
+      std::memcpy(euclidean_step_, target.euclidean_step, sizeof(euclidean_step_));
+      pulse_ = 0;
+      first_beat_ = (sequence_step_ == 0);
+      beat_ = (beat_mask_ >> sequence_step_) & 1u;
+      state_ = 0;
+      pulse_duration_counter_ = 0;
+      internal_clock_ticks_ = 0;
+      InvalidateLookahead();
+      Evaluate(); // Evaluate to set the trigger states of the new position
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::Retrigger()
+    {
+      // Re-evaluate the current step without advancing time
+      Evaluate();
+    }
+
+    // Placeholder for swing implementation. Original Grids swing was tied to its internal
+    // 24PPQN clock and affected by the randomness parameter in drum mode.
+    // A full implementation would require delaying specific pulses based on the clock mode.
+    // Currently returns 0, effectively disabling swing from this module.
+    // int8_t PatternGenerator::swing_amount()
+    // {
+    //   if (!options_.swing) // Removed: Swing functionality is being removed
+    //     return 0;
+    //   // Original Grids swing was subtle and tied to its 24PPQN clock structure.
+    //   // This is a simplified placeholder. A proper swing implementation would
+    //   // delay every second 16th note (or equivalent based on resolution).
+    //   // For now, just return a small fixed offset if swing is on.
+    //   // This would need to be applied to timing of specific pulses.
+    //   // The Disting NT might have its own swing handling or expect this module to provide timed triggers.
+    //   // Let's return 0 for now, as applying swing correctly requires deeper integration with the host clock.
+    //   return 0;
+    // }  // Removed: Swing functionality is being removed
+
+    // `external_clock_tick = true` signals one tick from the host/external clock source.
+    template <uint8_t kParts, uint8_t kSteps>
+    bool BasicPatternGenerator<kParts, kSteps>::TickClock(bool external_clock_tick)
+    {
+      if (!external_clock_tick) // Only process if there's an actual external clock tick
+      {
+        return false;
+      }
+
+      // Each tick is worth kPulsesPerTick 24 PPQN pulses (original Grids clocking always counts
+      // 24 PPQN ticks) and a step takes kPulsesPerStep of them, so a tick plays two steps, one,
+      // or a third of one. The remainder carries over, also across a resolution change.
+      internal_clock_ticks_ += options_.original_grids_clocking ? 1 : kPulsesPerTick[options_.clock_resolution];
+      uint8_t steps_advanced = 0;
+      StepPosition next = position();
+      while (internal_clock_ticks_ >= kPulsesPerStep)
+      {
+        internal_clock_ticks_ -= kPulsesPerStep;
+        AdvancePosition(next);
+        ++steps_advanced;
+      }
+
+      const bool stepped = steps_advanced > 0;
+      if (stepped)
+      {
+        sequence_step_ = next.step;
+        step_ = next.step;
+        bar_ = next.bar;
+        std::memcpy(euclidean_step_, next.euclidean_step, sizeof(euclidean_step_));
+
+        first_beat_ = (sequence_step_ == 0); // AdvancePosition wraps at pattern_length_
+        beat_ = (beat_mask_ >> sequence_step_) & 1u;
+        lookahead_consumed_ = (uint8_t)std::min<int>(lookahead_consumed_ + steps_advanced, kLookaheadSteps);
+
+        // Steps passed over are not played; drop them from the lookahead. Then take the
+        // precomputed state if the lookahead has this step; evaluate otherwise.
+        for (; steps_advanced > 1 && lookahead_count_ > 0; --steps_advanced)
+        {
+          lookahead_head_ = (lookahead_head_ + 1) & (kLookaheadSteps - 1);
+          lookahead_count_--;
+        }
+        const LookaheadEntry &entry = lookahead_[lookahead_head_];
+        if (lookahead_count_ > 0 && entry.bar == bar_ && entry.step == step_)
+        {
+          state_ = entry.state;
+          pulse_duration_counter_ = 0;
+          lookahead_head_ = (lookahead_head_ + 1) & (kLookaheadSteps - 1);
+          lookahead_count_--;
+        }
+        else
+        {
+          InvalidateLookahead();
+          Evaluate(); // Evaluate patterns based on the new step
+        }
+      }
+
+      IncrementPulseCounter(); // Handle pulse durations on every external tick, regardless of main step advancement
+      return stepped;
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    typename BasicPatternGenerator<kParts, kSteps>::StepPosition
+    BasicPatternGenerator<kParts, kSteps>::position() const
+    {
+      StepPosition current;
+      current.bar = bar_;
+      current.step = sequence_step_;
+      std::memcpy(current.euclidean_step, euclidean_step_, sizeof(current.euclidean_step));
+      return current;
+    }
+
+    // Main steps since Reset: bar * pattern_length_ + step. Direct clocking advances each
+    // Euclidean part on every one of them; original Grids clocking only when leaving an even
+    // step, i.e. (pattern_length_ + 1) / 2 times per bar plus (step + 1) / 2. Reduced modulo the
+    // length before multiplying, so any bar works.
+    template <uint8_t kParts, uint8_t kSteps>
+    typename BasicPatternGenerator<kParts, kSteps>::StepPosition
+    BasicPatternGenerator<kParts, kSteps>::PositionAt(uint32_t bar, uint8_t step) const
+    {
+      StepPosition target;
+      target.bar = bar;
+      target.step = step % pattern_length_;
+      for (uint8_t i = 0; i < kNumParts; ++i)
+      {
+        uint32_t length = current_euclidean_length_[i];
+        if (length == 0)
+        {
+          target.euclidean_step[i] = 0;
+          continue;
+        }
+        uint32_t advances = options_.original_grids_clocking
+                                ? (bar % length) * ((pattern_length_ + 1) / 2) + (target.step + 1) / 2
+                                : (bar % length) * pattern_length_ + target.step;
+        target.euclidean_step[i] = (uint8_t)(advances % length);
+      }
+      return target;
+    }
+
+    // Original Grids clocking steps the Euclidean parts on 8ths, i.e. when leaving an even main
+    // step; direct clocking steps them with every main step.
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::AdvancePosition(StepPosition &position) const
+    {
+      bool advance_euclidean = !options_.original_grids_clocking || !(position.step & 1);
+      for (uint8_t i = 0; i < kNumParts; ++i)
+      {
+        if (advance_euclidean && current_euclidean_length_[i] > 0)
+        {
+          position.euclidean_step[i] = (position.euclidean_step[i] + 1) % current_euclidean_length_[i];
+        }
+      }
+      // A compare instead of a modulo, so any length costs the same. Also wraps a step left
+      // beyond a length that was just shortened.
+      position.step = (position.step + 1 >= pattern_length_) ? 0 : position.step + 1;
+      position.bar += (position.step == 0);
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::FillLookahead(uint8_t max_steps)
+    {
+      if (lookahead_count_ == 0)
+      {
+        lookahead_head_ = 0;
+        lookahead_tail_ = position();
+      }
+      lookahead_consumed_ = 0;
+      for (; lookahead_count_ < kLookaheadSteps && max_steps > 0; --max_steps)
+      {
+        AdvancePosition(lookahead_tail_);
+        LookaheadEntry &entry = lookahead_[(lookahead_head_ + lookahead_count_) & (kLookaheadSteps - 1)];
+        entry.bar = lookahead_tail_.bar;
+        entry.step = lookahead_tail_.step;
+        entry.state = EvaluateAt(lookahead_tail_);
+        lookahead_count_++;
+      }
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::IncrementPulseCounter()
+    {
+      ++pulse_duration_counter_;
+      if (pulse_duration_counter_ >= kPulseDuration && !options_.gate_mode)
+      {
+        state_ = 0; // Triggers off after kPulseDuration if not in gate mode
+      }
+    }
+
+    // The original tap tempo functionality and related button handling (StartSetTempo, etc.)
+    // have been removed as this port relies on external clocking provided by the Disting NT host.
+    // void PatternGenerator::ClockFallingEdge() { ... }
+    // void PatternGenerator::RefreshTapTempo() { ... }
+    // void PatternGenerator::StartSetTempo() { ... }
+    // void PatternGenerator::StopSetTempo() { ... }
+    // void PatternGenerator::HandleSetTempoButton() { ... }
+
+    // Reads the drum map, interpolating between 4 points in the map.
+    // x and y are 0-255 coordinates for map interpolation.
+    template <uint8_t kParts, uint8_t kSteps>
+    uint8_t BasicPatternGenerator<kParts, kSteps>::ReadDrumMap(
+        uint8_t step,
+        uint8_t instrument,
+        uint8_t x, // 0-255, derived from UI Map X parameter
+        uint8_t y  // 0-255, derived from UI Map Y parameter
+    ) const
+    {
+      uint8_t i = x >> 6; // Determines a 2x2 cell in the 5x5 map based on X (quantized to 0-3 for cell index)
+      uint8_t j = y >> 6; // Determines a 2x2 cell in the 5x5 map based on Y (quantized to 0-3 for cell index)
+
+      // Ensure i and j are within bounds for a 5x5 map access (max index 3 for base of 2x2 cell)
+      // DrumMapAccess::drum_map_ptr is 5x5; accessing [i+1] or [j+1] requires i,j <= 3.
+      i = std::min(i, static_cast<uint8_t>(3));
+      j = std::min(j, static_cast<uint8_t>(3));
+
+      const uint8_t *a_map = DrumMapAccess::drum_map_ptr[j][i];         // Top-left node in the interpolation cell
+      const uint8_t *b_map = DrumMapAccess::drum_map_ptr[j][i + 1];     // Top-right node
+      const uint8_t *c_map = DrumMapAccess::drum_map_ptr[j + 1][i];     // Bottom-left node
+      const uint8_t *d_map = DrumMapAccess::drum_map_ptr[j + 1][i + 1]; // Bottom-right node
+
+      // The map holds nt_grids_port::kNumParts parts of nt_grids_port::kStepsPerPattern steps;
+      // variants with more parts or steps reuse it (parts and steps wrap). Folded away otherwise.
+      if (kParts > nt_grids_port::kNumParts)
+      {
+        instrument %= nt_grids_port::kNumParts;
+      }
+      if (kSteps > nt_grids_port::kStepsPerPattern)
+      {
+        step &= nt_grids_port::kStepsPerPattern - 1;
+      }
+      uint8_t offset = (instrument * nt_grids_port::kStepsPerPattern) + step;
+
+      uint8_t a = a_map[offset];
+      uint8_t b = b_map[offset];
+      uint8_t c = c_map[offset];
+      uint8_t d = d_map[offset];
+
+      // Interpolation weights are x % 64 and y % 64, scaled to 0-255 (by << 2)
+      uint8_t x_weight = (x % 64) << 2;
+      uint8_t y_weight = (y % 64) << 2;
+
+      return nt_grids_port::U8Mix(nt_grids_port::U8Mix(a, b, x_weight), nt_grids_port::U8Mix(c, d, x_weight), y_weight);
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::BuildDrumLevels(uint8_t x, uint8_t y, DrumLevels &drum_levels) const
+    {
+      for (uint8_t i = 0; i < kNumParts; ++i)
+      {
+        // Insertion sort of the steps by level, highest first. Equal levels always fall on the
+        // same side of a threshold, so their relative order does not matter.
+        uint8_t order[kStepsPerPattern];
+        uint8_t *levels = drum_levels.sorted_levels[i];
+        for (uint8_t step = 0; step < kStepsPerPattern; ++step)
+        {
+          uint8_t level = ReadDrumMap(step, i, x, y);
+          int k = step;
+          while (k > 0 && levels[k - 1] < level)
+          {
+            levels[k] = levels[k - 1];
+            order[k] = order[k - 1];
+            --k;
+          }
+          levels[k] = level;
+          order[k] = step;
+        }
+
+        StepMask mask = 0;
+        for (uint8_t k = 0; k < kStepsPerPattern; ++k)
+        {
+          mask |= (StepMask)1 << order[k];
+          drum_levels.rank_masks[i][k] = mask;
+        }
+      }
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::PrepareDrumLevels()
+    {
+      uint8_t x = settings_[OUTPUT_MODE_DRUMS].options.drums.x;
+      uint8_t y = settings_[OUTPUT_MODE_DRUMS].options.drums.y;
+      if (!drum_levels_valid_ || x != cached_x_ || y != cached_y_)
+      {
+        BuildDrumLevels(x, y, drum_levels_);
+        cached_x_ = x;
+        cached_y_ = y;
+        drum_levels_valid_ = true;
+      }
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    const typename BasicPatternGenerator<kParts, kSteps>::DrumLevels &
+    BasicPatternGenerator<kParts, kSteps>::CurrentDrumLevels(DrumLevels &scratch) const
+    {
+      uint8_t x = settings_[OUTPUT_MODE_DRUMS].options.drums.x;
+      uint8_t y = settings_[OUTPUT_MODE_DRUMS].options.drums.y;
+      if (drum_levels_valid_ && x == cached_x_ && y == cached_y_)
+      {
+        return drum_levels_;
+      }
+      BuildDrumLevels(x, y, scratch);
+      return scratch;
+    }
+
+    // Mask of the steps of `part` whose level is above `level_threshold` (which may be outside
+    // 0-255). Branch-free binary search over the sorted levels: five fixed steps plus one for 32
+    // entries (log2 of kSteps plus one in general), then one table load.
+    template <uint8_t kParts, uint8_t kSteps>
+    typename BasicPatternGenerator<kParts, kSteps>::StepMask
+    BasicPatternGenerator<kParts, kSteps>::DrumRankMask(const DrumLevels &drum_levels, uint8_t part,
+                                                        int level_threshold)
+    {
+      const uint8_t *levels = drum_levels.sorted_levels[part];
+      int count = 0; // Number of levels above the threshold (the halves sum to 31)
+      for (int half = kStepsPerPattern / 2; half > 0; half >>= 1)
+      {
+        count += (levels[count + half - 1] > level_threshold) ? half : 0;
+      }
+      count += (levels[count] > level_threshold) ? 1 : 0;
+      return drum_levels.rank_masks[part][(count - 1) & (kStepsPerPattern - 1)] & ((StepMask)0 - (StepMask)(count != 0));
+    }
+
+    // Per-part trigger and accent masks over the steps of `bar`. Constant-time: the same work
+    // runs whatever the pattern, density or chaos setting; selects replace the data-dependent
+    // branches (compiled to conditional moves).
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::DrumMasks(uint32_t bar, const DrumLevels &drum_levels,
+                                                          uint8_t *perturbation, StepMask *trigger_masks,
+                                                          StepMask *accent_masks) const
+    {
+      // One perturbation per part per bar: the random byte is drawn for step 0 of the bar, so it
+      // is the same on every step of the bar and can be recomputed at any position.
+      for (uint8_t i = 0; i < kNumParts; ++i)
+      {
+        perturbation[i] = DrumPerturbation(bar, i);
+      }
+
+      for (uint8_t i = 0; i < kNumParts; ++i)
+      {
+        // A step triggers when min(level + perturbation, 255) > ~density and accents when it
+        // also exceeds 192. Both are thresholds on the unperturbed level, i.e. rank prefixes.
+        // A density threshold of 255 can never be passed, even by a saturated level.
+        uint8_t density_threshold = ~settings_[OUTPUT_MODE_DRUMS].density[i];
+        trigger_masks[i] = DrumRankMask(drum_levels, i, (int)density_threshold - perturbation[i]) &
+                           ((StepMask)0 - (StepMask)(density_threshold != 255));
+        accent_masks[i] = trigger_masks[i] & DrumRankMask(drum_levels, i, 192 - perturbation[i]);
+      }
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    uint8_t BasicPatternGenerator<kParts, kSteps>::DrumState(uint8_t step, const StepMask *trigger_masks,
+                                                           const StepMask *accent_masks)
+    {
+      uint8_t new_state_for_tick = 0;    // Accumulates trigger and accent bits for the current tick
+      uint8_t accent_bits_for_parts = 0; // Any part with an accent on this step
+#pragma GCC unroll 8 // kParts <= 7: fully unrolled, the per-tick loop has no counter
+      for (uint8_t i = 0; i < kNumParts; ++i)
+      {
+        new_state_for_tick |= (uint8_t)(((trigger_masks[i] >> step) & 1u) << i); // OUTPUT_BIT_TRIG_1/2/3
+        accent_bits_for_parts |= (accent_masks[i] >> step) & 1u;
+      }
+
+      // Handle the ACCENT output bit (bit kParts: bit 3 / OUTPUT_BIT_ACCENT for three parts)
+      // In this port, accent is triggered if any part has an accent.
+      // Original Grids had more complex accent/common bit logic related to output_clock option.
+      new_state_for_tick |= (uint8_t)(accent_bits_for_parts << kParts);
+
+      // The original Grids' options_.output_clock logic for setting OUTPUT_BIT_RESET
+      // and modifying accent_bits based on clock/bar information has been removed
+      // to simplify for the plugin context. This port focuses on core triggers + one combined accent.
+      return new_state_for_tick;
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    uint8_t BasicPatternGenerator<kParts, kSteps>::DrumPerturbation(uint32_t bar, uint8_t part) const
+    {
+      uint8_t randomness = settings_[OUTPUT_MODE_DRUMS].options.drums.randomness;
+      randomness >>= 2; // Scale randomness for perturbation amount
+      return nt_grids_port::U8U8MulShift8(random_.GetByte(bar, 0, part), randomness);
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    uint8_t BasicPatternGenerator<kParts, kSteps>::EvaluateDrums(const StepPosition &position)
+    {
+      uint8_t perturbation[kNumParts];
+      StepMask trigger_masks[kNumParts];
+      StepMask accent_masks[kNumParts];
+      PrepareDrumLevels(); // No-op unless the settings were written without PrepareDrumLevels()
+      DrumMasks(position.bar, drum_levels_, perturbation, trigger_masks, accent_masks);
+      return DrumState(position.step, trigger_masks, accent_masks);
+    }
+
+    // Mask with each bit set with probability numerator / 2^denominator_bits. Works through the
+    // probability's binary digits from the least significant: OR-ing in a fresh random word
+    // maps a bit probability P to (1 + P) / 2, AND-ing maps it to P / 2.
+    template <uint8_t kParts, uint8_t kSteps>
+    typename BasicPatternGenerator<kParts, kSteps>::StepMask
+    BasicPatternGenerator<kParts, kSteps>::BernoulliMask(uint32_t numerator, uint8_t denominator_bits, uint32_t bar,
+                                                         uint8_t part, uint8_t stream) const
+    {
+      StepMask mask = 0;
+      for (uint8_t digit = 0; digit < denominator_bits; ++digit)
+      {
+        StepMask word = RandomMask(bar, digit, part, stream);
+        mask = ((numerator >> digit) & 1u) ? (mask | word) : (mask & word);
+      }
+      return mask;
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::PrepareEuclideanChaos(uint32_t bar)
+    {
+      uint8_t chaos_amount = settings_[OUTPUT_MODE_EUCLIDEAN].options.euclidean.chaos_amount;
+      chaos_amount = chaos_globally_enabled_ ? chaos_amount : 0;
+      uint8_t slot = bar & 1;
+      if (euclidean_chaos_valid_[slot] && euclidean_chaos_bar_[slot] == bar && euclidean_chaos_amount_[slot] == chaos_amount)
+      {
+        return;
+      }
+      euclidean_chaos_bar_[slot] = bar;
+      euclidean_chaos_amount_[slot] = chaos_amount;
+      euclidean_chaos_valid_[slot] = true;
+      EuclideanChaosMasks(bar, euclidean_flip_mask_[slot], euclidean_accent_mask_[slot]);
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::EuclideanChaosMasks(uint32_t bar, StepMask *flip_masks,
+                                                                    StepMask *accent_masks) const
+    {
+      uint8_t chaos_amount = settings_[OUTPUT_MODE_EUCLIDEAN].options.euclidean.chaos_amount;
+      chaos_amount = chaos_globally_enabled_ ? chaos_amount : 0;
+      // Both masks are always drawn and then selected, so the bar-boundary cost is the same at
+      // every chaos amount, including off.
+      const StepMask flip_select = (StepMask)0 - (StepMask)(chaos_amount != 0);
+      const StepMask accent_select = (StepMask)0 - (StepMask)(chaos_amount > 192);
+      for (uint8_t i = 0; i < kNumParts; ++i)
+      {
+        flip_masks[i] = BernoulliMask(chaos_amount, 11, bar, i, 1) & flip_select;
+        accent_masks[i] = BernoulliMask(chaos_amount, 12, bar, i, 2) & accent_select;
+      }
+    }
+
+    // Pattern and chaos are both masks: given the bar's chaos masks, each part is three bit tests.
+    template <uint8_t kParts, uint8_t kSteps>
+    uint8_t BasicPatternGenerator<kParts, kSteps>::EuclideanState(const StepPosition &position,
+                                                                const StepMask *flip_masks,
+                                                                const StepMask *accent_masks) const
+    {
+      uint8_t new_state = 0;
+      uint32_t accent = 0;
+      for (uint8_t i = 0; i < kNumParts; ++i)
+      {
+        uint32_t hit = euclidean_mask_[i] >> position.euclidean_step[i];
+        StepMask flip = flip_masks[i] >> position.step;
+        new_state |= (uint8_t)(((hit ^ flip) & 1u) << i);
+        accent |= accent_masks[i] >> position.step;
+      }
+      new_state |= (uint8_t)((accent & 1u) << kParts); // OUTPUT_BIT_ACCENT
+      return new_state;
+    }
+
+    // The chaos masks are cached, so after the once-per-bar rebuild each step is bit tests only.
+    template <uint8_t kParts, uint8_t kSteps>
+    uint8_t BasicPatternGenerator<kParts, kSteps>::EvaluateEuclidean(const StepPosition &position)
+    {
+      PrepareEuclideanChaos(position.bar);
+      uint8_t slot = position.bar & 1;
+      return EuclideanState(position, euclidean_flip_mask_[slot], euclidean_accent_mask_[slot]);
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    uint8_t BasicPatternGenerator<kParts, kSteps>::EvaluateAt(const StepPosition &position)
+    {
+      if (options_.output_mode == OUTPUT_MODE_DRUMS)
+      {
+        return EvaluateDrums(position);
+      }
+      return EvaluateEuclidean(position);
+    }
+
+    // The drum and chaos masks cover a whole bar, so they are built once per bar, into locals,
+    // and every step after that is bit extraction. The drum rank tables are the cached ones
+    // unless x/y changed without PrepareDrumLevels().
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::RenderSteps(const StepPosition &start, uint16_t count, uint8_t *states,
+                                                            uint8_t (*levels)[kNumParts]) const
+    {
+      StepPosition position = start;
+      bool drums = options_.output_mode == OUTPUT_MODE_DRUMS;
+      DrumLevels scratch_levels;
+      const DrumLevels &drum_levels = drums ? CurrentDrumLevels(scratch_levels) : drum_levels_;
+      uint8_t perturbation[kNumParts];
+      StepMask trigger_masks[kNumParts]; // Drum triggers, or the Euclidean chaos flips
+      StepMask accent_masks[kNumParts];
+      uint8_t x = settings_[OUTPUT_MODE_DRUMS].options.drums.x;
+      uint8_t y = settings_[OUTPUT_MODE_DRUMS].options.drums.y;
+      for (uint16_t n = 0; n < count; ++n)
+      {
+        if (drums)
+        {
+          if (n == 0 || position.step == 0)
+          {
+            DrumMasks(position.bar, drum_levels, perturbation, trigger_masks, accent_masks);
+          }
+          states[n] = DrumState(position.step, trigger_masks, accent_masks);
+        }
+        else
+        {
+          if (n == 0 || position.step == 0)
+          {
+            EuclideanChaosMasks(position.bar, trigger_masks, accent_masks);
+          }
+          states[n] = EuclideanState(position, trigger_masks, accent_masks);
+        }
+
+        if (levels)
+        {
+          for (uint8_t i = 0; i < kNumParts; ++i)
+          {
+            if (drums)
+            {
+              uint16_t level = ReadDrumMap(position.step, i, x, y) + perturbation[i];
+              levels[n][i] = (uint8_t)(level > 255 ? 255 : level);
+            }
+            else
+            {
+              levels[n][i] = ((euclidean_mask_[i] >> position.euclidean_step[i]) & 1u) ? 255 : 0;
+            }
+          }
+        }
+        AdvancePosition(position);
+      }
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::Evaluate()
+    {
+      pulse_duration_counter_ = 0; // Reset pulse timer for new evaluation cycle
+
+      // The general random bit (0x80) from original Grids' Evaluate() that was ORed into state_
+      // is not explicitly added here. Accent generation is now handled within EvaluateDrums/Euclidean.
+      // A generic random trigger output could be added here if desired as a separate feature.
+
+      state_ = EvaluateAt(position());
+    }
+
+    // The fill is the number of events, clamped to the length, at every length.
+    // The shift rotates the pattern within its length, later in time: shift 1 moves the hit on
+    // step 0 to step 1.
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::UpdateEuclideanMask(uint8_t channel)
+    {
+      uint8_t length = current_euclidean_length_[channel];
+      if (length == 0)
+      {
+        euclidean_mask_[channel] = 0;
+        return;
+      }
+      uint8_t desired_fills = settings_[OUTPUT_MODE_EUCLIDEAN].density[channel];
+      desired_fills = (desired_fills > length) ? length : desired_fills;
+      uint32_t mask = EuclideanPattern(length, desired_fills);
+
+      uint8_t shift = euclidean_shift_[channel] % length;
+      if (shift != 0)
+      {
+        uint32_t length_mask = (length == 32) ? 0xffffffffu : ((1u << length) - 1);
+        mask = ((mask << shift) | (mask >> (length - shift))) & length_mask;
+      }
+      euclidean_mask_[channel] = mask;
+      InvalidateLookahead();
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::SetLength(uint8_t channel, uint8_t length)
+    {
+      if (channel >= kNumParts)
+        return;
+      // Clamp length to 1-32. Disting parameters might send 0, which is invalid for length.
+      if (length == 0)
+        length = 1;
+      if (length > 32)
+        length = 32;
+      current_euclidean_length_[channel] = length;
+      UpdateEuclideanMask(channel);
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::SetFill(uint8_t channel, uint8_t fill_param_value) // fill_param_value is 0-255 from UI
+    {
+      if (channel >= kNumParts)
+        return;
+      // Store the raw parameter value in settings.density for Euclidean mode; the pattern mask
+      // is derived from it below.
+      settings_[OUTPUT_MODE_EUCLIDEAN].density[channel] = fill_param_value;
+      UpdateEuclideanMask(channel);
+
+      uint8_t current_length = current_euclidean_length_[channel];
+      if (current_length == 0) // Should be caught by SetLength clamping, but defensive.
+      {
+        fill_[channel] = 0;
+        return;
+      }
+      // Scale fill_param_value (0-255) to the number of active steps (0 to current_length).
+      // This fill_[channel] is mostly for potential display or alternative logic, not for the mask.
+      uint8_t active_steps = (static_cast<uint16_t>(fill_param_value) * current_length + 127) / 255; // Add 127 for rounding
+
+      if (active_steps > current_length)
+        active_steps = current_length; // Clamp active_steps to current_length
+      if (fill_param_value > 0 && active_steps == 0 && current_length > 0)
+        active_steps = 1; // Ensure at least 1 step if fill > 0
+      if (fill_param_value == 255)
+        active_steps = current_length; // Max fill means all steps active
+
+      fill_[channel] = active_steps;
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::SetShift(uint8_t channel, uint8_t shift)
+    {
+      if (channel >= kNumParts)
+        return;
+      euclidean_shift_[channel] = shift;
+      UpdateEuclideanMask(channel);
+    }
+
+    // The drum masks stay whole: steps from the length on are simply never reached, so the map
+    // is truncated and a bar costs the same at any length. Beats stay on the kSteps / 4 grid;
+    // the last one is short when the length is not a multiple of it (28 steps = 7/8).
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::SetPatternLength(uint8_t length)
+    {
+      if (length == 0)
+        length = 1;
+      if (length > kStepsPerPattern)
+        length = kStepsPerPattern;
+      pattern_length_ = length;
+      beat_mask_ = 0;
+      for (uint8_t step = 0; step < length; step += kStepsPerPattern / 4)
+      {
+        beat_mask_ |= (StepMask)1 << step;
+      }
+      InvalidateLookahead();
+    }
+
+    template <uint8_t kParts, uint8_t kSteps>
+    void BasicPatternGenerator<kParts, kSteps>::set_original_grids_clocking(bool enabled)
+    {
+      options_.original_grids_clocking = enabled;
+      internal_clock_ticks_ = 0; // Reset internal tick counter on mode change for a clean start
+      InvalidateLookahead();
+    }
+
+  } // namespace grids
+} // namespace nt_grids_port
+
+#endif // NT_GRIDS_PATTERN_GENERATOR_IMPL_H_
@@ -28,12 +28,9 @@ namespace nt_grids_port
   const uint8_t kStepsPerPattern = 32;
 
   // Sizes from grids/resources.h
-  const int LUT_RES_EUCLIDEAN_SIZE = 1024;
   const int NODE_DATA_SIZE = 96; // All node_X arrays are 96 bytes
 
   // External declarations for data arrays (definitions will be in .cc file)
-  extern const uint32_t lut_res_euclidean[LUT_RES_EUCLIDEAN_SIZE];
-
   extern const uint8_t node_0[NODE_DATA_SIZE];
   extern const uint8_t node_1[NODE_DATA_SIZE];
   extern const uint8_t node_2[NODE_DATA_SIZE];
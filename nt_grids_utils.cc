@@ -21,9 +21,8 @@
 namespace nt_grids_port
 {
 
-  // Static member definitions are still needed if they are not const static inline / constexpr in C++17
-  uint16_t Random::rng_state_ = 0xACE1; // Initial arbitrary seed, Init() will override if called
-  bool Random::s_seeded_ = false;
+  // Out-of-line definition for the in-class constant (C++11 needs one if it is odr-used)
+  const uint32_t Random::kDefaultSeed;
 
   // All method definitions below were previously causing redefinition errors
   // as they are now defined inline in the header. They are removed.
@@ -18,7 +18,7 @@
 #ifndef NT_GRIDS_UTILS_H_
 #define NT_GRIDS_UTILS_H_
 
-#include <stdint.h> // For uint8_t, uint16_t
+#include <stdint.h> // For uint8_t, uint16_t, uint32_t
 // #include <stdlib.h> // No longer needed if not using rand()/srand()
 #include <cstring>         // For memset, C++ style
 #include "distingnt/api.h" // For NT_getCpuCycleCount()
@@ -47,63 +47,58 @@ namespace nt_grids_port
     return (uint16_t)a * b;
   }
 
-  // Ported Random class from avrlib/random.h
+  // Counter-based random source. Replaces the avrlib Galois LFSR: instead of stepping a
+  // shared state, every value is a hash of (seed, bar, step, part), so chaos is reproducible
+  // for a given seed, does not depend on how often Evaluate ran, and any position can be
+  // computed directly. One instance (one seed) per pattern generator.
   class Random
   {
   public:
-    static void Init()
-    {
-      if (!s_seeded_)
-      {
-        rng_state_ = 0xACE1; // Use a fixed seed, bypassing NT_getCpuCycleCount() for now
-        // rng_state_ = static_cast<uint16_t>(NT_getCpuCycleCount() & 0xFFFF); // Use lower 16 bits of CPU cycle count
-        // if (rng_state_ == 0)
-        //   rng_state_ = 0xACE1; // Ensure seed is not zero, as LFSR can get stuck
-        s_seeded_ = true;
-      }
-    }
+    static const uint32_t kDefaultSeed = 0xACE1;
 
-    static void Seed(uint16_t seed)
-    {
-      rng_state_ = seed;
-      s_seeded_ = true; // Consider if explicit seeding should override srand approach
-    }
+    Random() { Seed(kDefaultSeed); }
 
-    static void Update()
+    void Init()
     {
-      // Galois LFSR with feedback polynomial = x^16 + x^14 + x^13 + x^11.
-      // Period: 65535.
-      rng_state_ = (rng_state_ >> 1) ^ (-(rng_state_ & 1) & 0xb400);
+      Seed(kDefaultSeed);
     }
 
-    static inline uint16_t state() { return rng_state_; }
-
-    static inline uint8_t state_msb()
+    void Seed(uint32_t seed)
     {
-      return static_cast<uint8_t>(rng_state_ >> 8);
+      seed_ = seed;
+      key_ = Mix(seed ^ 0x5bd1e995u); // Spread small seeds over the whole key
     }
 
-    static inline uint8_t GetByte()
+    uint32_t seed() const { return seed_; }
+
+    // 32 random bits for one position. `stream` separates independent draws made at the same
+    // position.
+    inline uint32_t GetWord(uint32_t bar, uint8_t step, uint8_t part, uint8_t stream = 0) const
     {
-      Update();
-      return state_msb();
+      uint32_t counter = bar * 0x9e3779b9u + ((uint32_t)stream << 16 | (uint32_t)step << 8 | part);
+      return Mix(Mix(counter) ^ key_);
     }
 
-    static inline uint8_t GetControlByte()
+    inline uint8_t GetByte(uint32_t bar, uint8_t step, uint8_t part, uint8_t stream = 0) const
     {
-      Update();
-      return static_cast<uint8_t>((state() >> 8) & 0xFF);
+      return static_cast<uint8_t>(GetWord(bar, step, part, stream) >> 24);
     }
 
-    static inline uint16_t GetWord()
+    // 32-bit integer finaliser (xor-shift-multiply, "lowbias32"): a bijection with full
+    // avalanche, two multiplies on the Cortex-M7.
+    static inline uint32_t Mix(uint32_t x)
     {
-      Update();
-      return state();
+      x ^= x >> 16;
+      x *= 0x7feb352du;
+      x ^= x >> 15;
+      x *= 0x846ca68bu;
+      x ^= x >> 16;
+      return x;
     }
 
   private:
-    static uint16_t rng_state_;
-    static bool s_seeded_; // To ensure srand is called only once by default Init
+    uint32_t seed_;
+    uint32_t key_;
 
     DISALLOW_COPY_AND_ASSIGN(Random);
   };
@@ -0,0 +1,38 @@
+// Host-side definitions of the Disting NT API symbols the plugin links against.
+// On hardware these are provided by the firmware; the unit tests only need them
+// to exist and to behave plausibly.
+
+#include "distingnt/api.h"
+#include <chrono>
+#include <cstdio>
+
+const _NT_globals NT_globals = {48000, 128};
+
+void NT_drawText(int x, int y, const char *str, int colour, _NT_textAlignment align, _NT_textSize size)
+{
+}
+
+int NT_intToString(char *buffer, int32_t value)
+{
+  return snprintf(buffer, 12, "%d", (int)value);
+}
+
+uint32_t NT_algorithmIndex(const _NT_algorithm *algorithm)
+{
+  return 0;
+}
+
+uint32_t NT_parameterOffset(void)
+{
+  return 0;
+}
+
+void NT_setParameterFromUi(uint32_t algorithmIndex, uint32_t parameter, int16_t value)
+{
+}
+
+uint32_t NT_getCpuCycleCount(void)
+{
+  using namespace std::chrono;
+  return (uint32_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
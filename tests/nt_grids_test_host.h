@@ -0,0 +1,72 @@
+#ifndef NT_GRIDS_TEST_HOST_H
+#define NT_GRIDS_TEST_HOST_H
+
+#include <vector>
+
+#include "distingnt/api.h"
+#include "nt_grids.h"                // For NtGridsAlgorithm, s_parameters
+#include "nt_grids_parameter_defs.h" // For ParameterIndex, kNumParameters
+
+extern "C" uintptr_t pluginEntry(_NT_selector selector, uint32_t data);
+
+// Drives one plugin instance through the factory callbacks in the same order the
+// Disting NT host does: static init, requirements, construct, then step/parameterChanged.
+class NtGridsTestHost
+{
+public:
+  NtGridsTestHost()
+      : factory(reinterpret_cast<const _NT_factory *>(pluginEntry(kNT_selector_factoryInfo, 0)))
+  {
+    static bool s_initialised = false;
+    if (!s_initialised)
+    {
+      _NT_staticRequirements static_req = {};
+      factory->calculateStaticRequirements(static_req);
+      _NT_staticMemoryPtrs static_ptrs = {};
+      factory->initialise(static_ptrs, static_req);
+      s_initialised = true;
+    }
+
+    for (int i = 0; i < kNumParameters; ++i)
+    {
+      values[i] = s_parameters[i].def;
+    }
+
+    _NT_algorithmRequirements req = {};
+    factory->calculateRequirements(req, nullptr);
+    sram.assign((req.sram + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+
+    // The host publishes the parameter values before calling construct().
+    reinterpret_cast<_NT_algorithm *>(sram.data())->v = values;
+
+    _NT_algorithmMemoryPtrs ptrs = {};
+    ptrs.sram = reinterpret_cast<uint8_t *>(sram.data());
+    algorithm = static_cast<NtGridsAlgorithm *>(factory->construct(ptrs, req, nullptr));
+  }
+
+  ~NtGridsTestHost()
+  {
+    algorithm->~NtGridsAlgorithm();
+  }
+
+  void setParameter(ParameterIndex p_idx, int16_t value)
+  {
+    values[p_idx] = value;
+    factory->parameterChanged(algorithm, p_idx);
+  }
+
+  // busFrames holds 28 planar buses of numFramesBy4 * 4 samples each.
+  void step(std::vector<float> &busFrames, int numFramesBy4)
+  {
+    factory->step(algorithm, busFrames.data(), numFramesBy4);
+  }
+
+  const _NT_factory *factory;
+  NtGridsAlgorithm *algorithm;
+  int16_t values[kNumParameters];
+
+private:
+  std::vector<uint64_t> sram;
+};
+
+#endif // NT_GRIDS_TEST_HOST_H
@@ -0,0 +1,246 @@
+#include "doctest.h"
+#include "nt_grids_edge_scan.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+// Scalar compare-and-branch detector, as nt_grids_step used to run it per sample. Baseline for
+// the benchmark.
+static int legacy_rising(const float *bus, int count, float threshold, float *prev, uint16_t *offsets)
+{
+  int num_edges = 0;
+  for (int s = 0; s < count; ++s)
+  {
+    if (bus[s] > threshold && *prev <= threshold)
+    {
+      offsets[num_edges++] = (uint16_t)s;
+    }
+    *prev = bus[s];
+  }
+  return num_edges;
+}
+
+// Per-sample Schmitt trigger with a minimum interval between accepted edges: the reference
+// the kernel must match exactly.
+struct ReferenceDetector
+{
+  bool latch;
+  uint64_t sample;
+  uint64_t last_accepted;
+  bool any_accepted;
+  uint32_t rejected;
+
+  ReferenceDetector() : latch(false), sample(0), last_accepted(0), any_accepted(false), rejected(0) {}
+
+  int scan(const float *bus, int count, const EdgeScanConfig &config, uint16_t *offsets)
+  {
+    int num_edges = 0;
+    for (int s = 0; s < count; ++s, ++sample)
+    {
+      bool was = latch;
+      if (bus[s] > config.high)
+        latch = true;
+      else if (bus[s] <= config.low)
+        latch = false;
+      if (latch && !was)
+      {
+        if (any_accepted && sample - last_accepted < config.min_interval)
+        {
+          rejected++;
+          continue;
+        }
+        any_accepted = true;
+        last_accepted = sample;
+        offsets[num_edges++] = (uint16_t)s;
+      }
+    }
+    return num_edges;
+  }
+};
+
+static EdgeScanConfig make_config(float high, float low, uint32_t min_interval)
+{
+  EdgeScanConfig config;
+  config.high = high;
+  config.low = low;
+  config.min_interval = min_interval;
+  return config;
+}
+
+// Mostly low/high runs with some noise around the threshold, plus negative values.
+static std::vector<float> random_cv(int count, unsigned seed)
+{
+  std::vector<float> cv(count);
+  srand(seed);
+  for (int s = 0; s < count; ++s)
+  {
+    switch (rand() % 6)
+    {
+    case 0:
+      cv[s] = 0.5f; // Exactly on the threshold counts as low
+      break;
+    case 1:
+      cv[s] = -5.0f + (rand() % 1000) * 0.01f;
+      break;
+    default:
+      cv[s] = (s > 0 && rand() % 4) ? cv[s - 1] : ((rand() & 1) ? 5.0f : 0.0f);
+      break;
+    }
+  }
+  return cv;
+}
+
+TEST_SUITE("Edge scan")
+{
+  TEST_CASE("Rising edges match the per-sample Schmitt detector across blocks")
+  {
+    const EdgeScanConfig configs[4] = {make_config(0.5f, 0.5f, 0), make_config(1.0f, 0.5f, 0),
+                                       make_config(3.0f, 0.2f, 0), make_config(1.0f, 0.5f, 9)};
+    for (int c = 0; c < 4; ++c)
+    {
+      for (int count = 1; count <= 300; count += 7)
+      {
+        std::vector<float> cv = random_cv(count * 4, (unsigned)count);
+        ReferenceDetector reference;
+        EdgeScanState state;
+        for (int block = 0; block < 4; ++block)
+        {
+          const float *in = &cv[block * count];
+          std::vector<uint16_t> expected(count / 2 + 1), got(count / 2 + 1);
+          int num_expected = reference.scan(in, count, configs[c], &expected[0]);
+          int num_got = edge_scan_rising(in, count, configs[c], &state, &got[0]);
+          REQUIRE(num_got == num_expected);
+          for (int e = 0; e < num_got; ++e)
+          {
+            CHECK(got[e] == expected[e]);
+          }
+          CHECK(state.above == (reference.latch ? 1u : 0u));
+          CHECK(state.rejected_edges == reference.rejected);
+        }
+      }
+    }
+  }
+
+  TEST_CASE("Hysteresis ignores noise between the thresholds")
+  {
+    // A slow ramp with +-0.3V ripple: one edge with hysteresis, several without.
+    const int count = 256;
+    std::vector<float> cv(count);
+    for (int s = 0; s < count; ++s)
+    {
+      cv[s] = (s * 2.0f / count) + ((s & 1) ? 0.3f : -0.3f);
+    }
+    uint16_t offsets[count];
+    EdgeScanState plain, schmitt;
+    CHECK(edge_scan_rising(&cv[0], count, make_config(0.5f, 0.5f, 0), &plain, offsets) > 1);
+    CHECK(edge_scan_rising(&cv[0], count, make_config(1.0f, 0.2f, 0), &schmitt, offsets) == 1);
+  }
+
+  TEST_CASE("Edges inside the minimum interval are rejected and counted")
+  {
+    const int count = 64;
+    std::vector<float> cv(count, 0.0f);
+    cv[10] = cv[13] = cv[40] = 5.0f; // 13 is a glitch 3 samples after 10
+    uint16_t offsets[count];
+    EdgeScanState state;
+    int num = edge_scan_rising(&cv[0], count, make_config(1.0f, 0.5f, 8), &state, offsets);
+    REQUIRE(num == 2);
+    CHECK(offsets[0] == 10);
+    CHECK(offsets[1] == 40);
+    CHECK(state.rejected_edges == 1u);
+  }
+
+  TEST_CASE("Float and integer mask paths agree")
+  {
+    std::vector<float> cv = random_cv(32 * 64, 7u);
+    const float thresholds[3] = {0.0f, 0.5f, 2.5f};
+    for (int t = 0; t < 3; ++t)
+    {
+      for (int w = 0; w < 64; ++w)
+      {
+        for (int n = 1; n <= 32; n += 31)
+        {
+          CHECK(edge_scan_above_mask_float(&cv[w * 32], n, thresholds[t]) ==
+                edge_scan_above_mask_bits(&cv[w * 32], n, thresholds[t]));
+        }
+      }
+    }
+  }
+
+  TEST_CASE("Pair scan merges both inputs in sample order")
+  {
+    const int count = 100;
+    std::vector<float> a = random_cv(count, 11u), b = random_cv(count, 12u);
+    a[40] = 0.0f;
+    a[41] = 5.0f;
+    b[40] = 0.0f;
+    b[41] = 5.0f; // Coincident edge
+
+    const EdgeScanConfig config = make_config(1.0f, 0.5f, 0);
+    ReferenceDetector reference_a, reference_b;
+    uint16_t edges_a[count], edges_b[count];
+    int num_a = reference_a.scan(&a[0], count, config, edges_a);
+    int num_b = reference_b.scan(&b[0], count, config, edges_b);
+
+    EdgeScanState state_a, state_b;
+    EdgeScanHit hits[count];
+    int num_hits = edge_scan_rising_pair(&a[0], &b[0], count, config, config, &state_a, &state_b, hits);
+
+    int ia = 0, ib = 0;
+    for (int h = 0; h < num_hits; ++h)
+    {
+      if (h > 0)
+        CHECK(hits[h].sample_offset > hits[h - 1].sample_offset);
+      if (hits[h].inputs & kEdgeScanInputA)
+        CHECK(edges_a[ia++] == hits[h].sample_offset);
+      if (hits[h].inputs & kEdgeScanInputB)
+        CHECK(edges_b[ib++] == hits[h].sample_offset);
+    }
+    CHECK(ia == num_a);
+    CHECK(ib == num_b);
+
+    // A missing bus never fires and reads as low.
+    state_b.above = 1;
+    num_hits = edge_scan_rising_pair(&a[0], nullptr, count, config, config, &state_a, &state_b, hits);
+    for (int h = 0; h < num_hits; ++h)
+      CHECK(hits[h].inputs == kEdgeScanInputA);
+    CHECK(state_b.above == 0u);
+  }
+
+  // Micro-benchmark, skipped by default: run with `-ts="Edge scan" --no-skip` (build -O2 or -Os).
+  TEST_CASE("Benchmark: edge scan kernel vs per-sample loop" * doctest::skip())
+  {
+    const int count = 128;
+    const int blocks = 200000;
+    std::vector<float> clock = random_cv(count * 16, 21u), reset = random_cv(count * 16, 22u);
+    uint16_t offsets[count];
+    EdgeScanHit hits[count + 2];
+    volatile int sink = 0;
+
+    typedef std::chrono::steady_clock clk;
+    clk::time_point t0 = clk::now();
+    float prev_clock = 0.0f, prev_reset = 0.0f;
+    for (int i = 0; i < blocks; ++i)
+    {
+      int off = (i & 15) * count;
+      sink += legacy_rising(&clock[off], count, 0.5f, &prev_clock, offsets);
+      sink += legacy_rising(&reset[off], count, 0.5f, &prev_reset, offsets);
+    }
+    clk::time_point t1 = clk::now();
+    EdgeScanState state_clock, state_reset;
+    const EdgeScanConfig config = make_config(1.0f, 0.5f, 0);
+    for (int i = 0; i < blocks; ++i)
+    {
+      int off = (i & 15) * count;
+      sink += edge_scan_rising_pair(&clock[off], &reset[off], count, config, config, &state_clock, &state_reset, hits);
+    }
+    clk::time_point t2 = clk::now();
+
+    double loop_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / blocks;
+    double kernel_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / blocks;
+    MESSAGE("per-sample loop: " << loop_ns << " ns/block, Schmitt kernel: " << kernel_ns << " ns/block ("
+                                << count << " frames, clock + reset)");
+    CHECK(sink != 0);
+  }
+}
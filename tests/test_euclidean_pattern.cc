@@ -0,0 +1,153 @@
+#include "doctest.h"
+#include "lut_res_euclidean_reference.h"
+#include "nt_grids_euclidean_pattern.h"
+#include "nt_grids_pattern_generator.h"
+
+using nt_grids_port::EuclideanPattern;
+using nt_grids_port::EuclideanTableMask;
+using nt_grids_port::grids::PatternGenerator;
+using nt_grids_port::grids::OUTPUT_MODE_EUCLIDEAN;
+
+static int count_bits(uint32_t mask)
+{
+  int count = 0;
+  for (; mask; mask &= mask - 1)
+    ++count;
+  return count;
+}
+
+TEST_SUITE("Euclidean pattern")
+{
+  TEST_CASE("Computed masks are bit-identical to the old lookup table")
+  {
+    for (int length = 1; length <= 32; ++length)
+    {
+      for (int density = 0; density <= 31; ++density)
+      {
+        CAPTURE(length);
+        CAPTURE(density);
+        CHECK(EuclideanTableMask((uint8_t)length, (uint8_t)density) ==
+              kReferenceEuclideanTable[(length - 1) * 32 + density]);
+      }
+    }
+  }
+
+  TEST_CASE("Bjorklund patterns have the requested notes, evenly spaced")
+  {
+    CHECK(EuclideanPattern(8, 3) == 0x29u); // x..x.x..
+    CHECK(EuclideanPattern(16, 4) == 0x1111u);
+    CHECK(EuclideanPattern(5, 0) == 0u);
+    CHECK(EuclideanPattern(32, 32) == 0xffffffffu);
+    for (int steps = 1; steps <= 32; ++steps)
+    {
+      for (int notes = 0; notes <= steps; ++notes)
+      {
+        uint32_t mask = EuclideanPattern((uint8_t)steps, (uint8_t)notes);
+        CAPTURE(steps);
+        CAPTURE(notes);
+        CHECK(count_bits(mask) == notes);
+        CHECK((steps == 32 || (mask >> steps) == 0));
+        if (notes > 0)
+          CHECK((mask & 1u) == 1u); // Patterns start on a note
+      }
+    }
+  }
+
+  TEST_CASE("Generator plays the cached mask for every length and fill")
+  {
+    PatternGenerator generator;
+    generator.set_output_mode(OUTPUT_MODE_EUCLIDEAN);
+    for (int length = 1; length <= 32; ++length)
+    {
+      for (int fill = 0; fill <= 40; fill += 3)
+      {
+        for (int p = 0; p < nt_grids_port::kNumParts; ++p)
+        {
+          generator.SetLength((uint8_t)p, (uint8_t)length);
+          generator.SetFill((uint8_t)p, (uint8_t)(fill + p));
+        }
+        generator.Reset();
+        for (int step = 0; step < 2 * length; ++step)
+        {
+          for (int p = 0; p < nt_grids_port::kNumParts; ++p)
+          {
+            int density = fill + p;
+            density = density > length ? length : density;
+            uint32_t mask = EuclideanPattern((uint8_t)length, (uint8_t)density);
+            uint32_t expected = (mask >> (step % length)) & 1u;
+            CAPTURE(length);
+            CAPTURE(fill);
+            CAPTURE(step);
+            CHECK(((generator.get_trigger_state() >> p) & 1u) == expected);
+          }
+          generator.TickClock(true);
+        }
+      }
+    }
+  }
+
+  TEST_CASE("Fill plays that many events within the length at every length")
+  {
+    PatternGenerator generator;
+    generator.set_output_mode(OUTPUT_MODE_EUCLIDEAN);
+    for (int length = 1; length <= 32; ++length)
+    {
+      for (int fill = 0; fill <= 32; ++fill)
+      {
+        CAPTURE(length);
+        CAPTURE(fill);
+        generator.SetLength(0, (uint8_t)length);
+        generator.SetFill(0, (uint8_t)fill);
+        const int notes = fill > length ? length : fill;
+        const uint32_t mask = generator.euclidean_mask_[0];
+        CHECK(count_bits(mask) == notes);
+        CHECK((length == 32 || (mask >> length) == 0));
+
+        generator.Reset();
+        int hits = 0;
+        for (int step = 0; step < length; ++step)
+        {
+          hits += generator.get_trigger_state() & 1u;
+          generator.TickClock(true);
+        }
+        CHECK(hits == notes);
+      }
+    }
+  }
+
+  TEST_CASE("Shift rotates the pattern later within its length")
+  {
+    PatternGenerator generator;
+    generator.set_output_mode(OUTPUT_MODE_EUCLIDEAN);
+    const int lengths[] = {1, 5, 16, 31, 32};
+    for (int l = 0; l < 5; ++l)
+    {
+      int length = lengths[l];
+      for (int shift = 0; shift < 40; shift += 3)
+      {
+        generator.SetLength(0, (uint8_t)length);
+        generator.SetFill(0, (uint8_t)(length / 3 + 1));
+        generator.SetShift(0, 0);
+        uint32_t unshifted[32];
+        generator.Reset();
+        for (int step = 0; step < length; ++step)
+        {
+          unshifted[step] = generator.get_trigger_state() & 1u;
+          generator.TickClock(true);
+        }
+
+        generator.SetShift(0, (uint8_t)shift);
+        generator.Reset();
+        for (int step = 0; step < 2 * length; ++step)
+        {
+          CAPTURE(length);
+          CAPTURE(shift);
+          CAPTURE(step);
+          int source = ((step - shift) % length + length) % length;
+          CHECK((generator.get_trigger_state() & 1u) == unshifted[source]);
+          generator.TickClock(true);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,95 @@
+#include "doctest.h"
+#include "nt_grids_test_host.h"
+#include "nt_grids_pattern_generator.h"
+
+#include <vector>
+
+// Each NT Grids instance owns its PatternGenerator, so several instances in one preset must
+// not clock, reset or reconfigure each other.
+
+static const int kClockBus = 0;
+static const int kNumBuses = 28;
+
+// Sends `ticks` clock edges to `host`, one per 4-frame block.
+static void send_ticks(NtGridsTestHost &host, int ticks)
+{
+  const int numFramesBy4 = 1;
+  const int n = numFramesBy4 * 4;
+  std::vector<float> bus(kNumBuses * n, 0.0f);
+  for (int t = 0; t < ticks; ++t)
+  {
+    bus[kClockBus * n + 0] = 0.0f;
+    bus[kClockBus * n + 1] = 5.0f;
+    bus[kClockBus * n + 2] = 5.0f;
+    bus[kClockBus * n + 3] = 0.0f;
+    host.step(bus, numFramesBy4);
+  }
+}
+
+TEST_SUITE("Instances")
+{
+  TEST_CASE("Clocking one instance does not advance another")
+  {
+    NtGridsTestHost a;
+    NtGridsTestHost b;
+    a.setParameter(kParamClockInput, kClockBus + 1);
+    b.setParameter(kParamClockInput, kClockBus + 1);
+
+    send_ticks(a, 5);
+    CHECK(a.algorithm->pattern_generator.step() == 5);
+    CHECK(b.algorithm->pattern_generator.step() == 0);
+
+    send_ticks(b, 2);
+    CHECK(a.algorithm->pattern_generator.step() == 5);
+    CHECK(b.algorithm->pattern_generator.step() == 2);
+  }
+
+  TEST_CASE("Constructing an instance does not reset a running one")
+  {
+    NtGridsTestHost a;
+    a.setParameter(kParamClockInput, kClockBus + 1);
+    send_ticks(a, 7);
+    NtGridsTestHost b;
+    CHECK(a.algorithm->pattern_generator.step() == 7);
+    CHECK(b.algorithm->pattern_generator.step() == 0);
+  }
+
+  TEST_CASE("Settings are per instance")
+  {
+    NtGridsTestHost a;
+    NtGridsTestHost b;
+    a.setParameter(kParamDrumMapX, 10);
+    b.setParameter(kParamDrumMapX, 250);
+    a.setParameter(kParamDrumDensity1, 0);
+    CHECK(a.algorithm->pattern_generator.settings_[nt_grids_port::grids::OUTPUT_MODE_DRUMS].options.drums.x == 10);
+    CHECK(b.algorithm->pattern_generator.settings_[nt_grids_port::grids::OUTPUT_MODE_DRUMS].options.drums.x == 250);
+    CHECK(b.algorithm->pattern_generator.settings_[nt_grids_port::grids::OUTPUT_MODE_DRUMS].density[0] == 128);
+
+    // Identical instances stay in lockstep when clocked the same, including chaos.
+    NtGridsTestHost c;
+    NtGridsTestHost d;
+    c.setParameter(kParamClockInput, kClockBus + 1);
+    d.setParameter(kParamClockInput, kClockBus + 1);
+    c.setParameter(kParamChaosEnable, 1);
+    d.setParameter(kParamChaosEnable, 1);
+    c.setParameter(kParamChaosAmount, 255);
+    d.setParameter(kParamChaosAmount, 255);
+    for (int t = 0; t < 64; ++t)
+    {
+      send_ticks(c, 1);
+      send_ticks(d, 1);
+      REQUIRE(c.algorithm->pattern_generator.get_trigger_state() == d.algorithm->pattern_generator.get_trigger_state());
+    }
+  }
+
+  TEST_CASE("Per-instance footprint")
+  {
+    _NT_algorithmRequirements req = {};
+    NtGridsTestHost host;
+    host.factory->calculateRequirements(req, nullptr);
+    MESSAGE("PatternGenerator: " << sizeof(nt_grids_port::grids::PatternGenerator)
+                                 << " bytes, NtGridsAlgorithm (SRAM per instance): " << req.sram << " bytes");
+    CHECK(req.sram == sizeof(NtGridsAlgorithm));
+    CHECK(sizeof(nt_grids_port::grids::PatternGenerator) <= 1024); // Keeps the footprint visible in review
+  }
+}
@@ -0,0 +1,727 @@
+#include "doctest.h"
+#include "nt_grids_pattern_generator.h"
+#include "nt_grids_pattern_generator_impl.h" // For the non-default variant
+#include "nt_grids_resources.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using nt_grids_port::grids::PatternGenerator;
+using nt_grids_port::grids::OUTPUT_MODE_DRUMS;
+using nt_grids_port::grids::OUTPUT_MODE_EUCLIDEAN;
+using nt_grids_port::grids::OUTPUT_BIT_ACCENT;
+
+// Drum state for the generator's current step computed straight from the drum map, the way
+// EvaluateDrums did before its levels and masks were cached.
+static uint8_t reference_drum_state(const PatternGenerator &generator)
+{
+  const nt_grids_port::grids::PatternGeneratorSettings &settings = generator.settings_[OUTPUT_MODE_DRUMS];
+  uint8_t x = settings.options.drums.x;
+  uint8_t y = settings.options.drums.y;
+  uint8_t i = std::min(x >> 6, 3);
+  uint8_t j = std::min(y >> 6, 3);
+  uint8_t x_weight = (x % 64) << 2;
+  uint8_t y_weight = (y % 64) << 2;
+
+  uint8_t state = 0;
+  for (int part = 0; part < nt_grids_port::kNumParts; ++part)
+  {
+    int offset = part * nt_grids_port::kStepsPerPattern + generator.step();
+    const uint8_t *const(*map)[5] = nt_grids_port::DrumMapAccess::drum_map_ptr;
+    uint8_t level = nt_grids_port::U8Mix(nt_grids_port::U8Mix(map[j][i][offset], map[j][i + 1][offset], x_weight),
+                                         nt_grids_port::U8Mix(map[j + 1][i][offset], map[j + 1][i + 1][offset], x_weight),
+                                         y_weight);
+    int perturbed = std::min(level + generator.part_perturbation(part), 255);
+    if (perturbed > (uint8_t)~settings.density[part])
+    {
+      state |= 1 << part;
+      if (perturbed > 192)
+        state |= OUTPUT_BIT_ACCENT;
+    }
+  }
+  return state;
+}
+
+static void set_drums(PatternGenerator &generator, uint8_t x, uint8_t y, uint8_t d1, uint8_t d2, uint8_t d3,
+                      uint8_t randomness)
+{
+  nt_grids_port::grids::PatternGeneratorSettings &settings = generator.settings_[OUTPUT_MODE_DRUMS];
+  settings.options.drums.x = x;
+  settings.options.drums.y = y;
+  settings.density[0] = d1;
+  settings.density[1] = d2;
+  settings.density[2] = d3;
+  settings.options.drums.randomness = randomness;
+}
+
+TEST_SUITE("Pattern generator")
+{
+  TEST_CASE("Cached drum evaluation matches the drum map")
+  {
+    PatternGenerator generator;
+    generator.set_output_mode(OUTPUT_MODE_DRUMS);
+    generator.Reset();
+    int checked = 0;
+    for (int x = 0; x < 256; x += 37)
+    {
+      for (int y = 0; y < 256; y += 41)
+      {
+        for (int d = 0; d < 256; d += 51)
+        {
+          // Chaos on for some combinations so the perturbation changes each bar.
+          set_drums(generator, (uint8_t)x, (uint8_t)y, (uint8_t)d, (uint8_t)(255 - d), (uint8_t)(d / 2),
+                    (uint8_t)(((x + y) & 64) ? 255 : 0));
+          for (int t = 0; t < 40; ++t)
+          {
+            if (t == 20)
+            {
+              // Mid-pattern density change must refresh that part's masks.
+              generator.settings_[OUTPUT_MODE_DRUMS].density[1] = (uint8_t)(d + 17);
+            }
+            generator.TickClock(true);
+            REQUIRE(generator.get_trigger_state() == reference_drum_state(generator));
+            ++checked;
+          }
+        }
+      }
+    }
+    CHECK(checked > 0);
+  }
+
+  TEST_CASE("Every density selects the right rank prefix")
+  {
+    // Sweeping density every step (as a fast LFO would) only re-selects prefixes; the result
+    // must still match the threshold over the levels for all 256 values.
+    PatternGenerator generator;
+    generator.set_output_mode(OUTPUT_MODE_DRUMS);
+    generator.Reset();
+    const uint8_t positions[4][2] = {{0, 0}, {128, 128}, {200, 60}, {255, 255}};
+    for (int p = 0; p < 4; ++p)
+    {
+      set_drums(generator, positions[p][0], positions[p][1], 0, 0, 0, (uint8_t)(p * 80));
+      for (int d = 0; d < 256; ++d)
+      {
+        for (int part = 0; part < nt_grids_port::kNumParts; ++part)
+        {
+          generator.settings_[OUTPUT_MODE_DRUMS].density[part] = (uint8_t)(d + part * 85);
+        }
+        generator.TickClock(true);
+        REQUIRE(generator.get_trigger_state() == reference_drum_state(generator));
+      }
+    }
+  }
+
+  TEST_CASE("Chaos is a pure function of seed and position")
+  {
+    const nt_grids_port::grids::OutputMode modes[2] = {OUTPUT_MODE_DRUMS, OUTPUT_MODE_EUCLIDEAN};
+    for (int m = 0; m < 2; ++m)
+    {
+      PatternGenerator a, b, c;
+      PatternGenerator *generators[3] = {&a, &b, &c};
+      for (int g = 0; g < 3; ++g)
+      {
+        generators[g]->set_output_mode(modes[m]);
+        generators[g]->set_global_chaos(true);
+        set_drums(*generators[g], 60, 200, 128, 128, 128, 255);
+        generators[g]->settings_[OUTPUT_MODE_EUCLIDEAN].options.euclidean.chaos_amount = 255;
+        generators[g]->set_seed(g == 2 ? 1234u : 42u);
+        generators[g]->Reset();
+      }
+
+      // b re-evaluates every step several times; that must not change what it plays.
+      int differences = 0;
+      for (int t = 0; t < 32 * 8; ++t)
+      {
+        b.Retrigger();
+        b.Retrigger();
+        REQUIRE(a.get_trigger_state() == b.get_trigger_state());
+        differences += a.get_trigger_state() != c.get_trigger_state();
+        a.TickClock(true);
+        b.TickClock(true);
+        c.TickClock(true);
+      }
+      CHECK(a.bar() == 8u);
+      CHECK(differences > 0); // Another seed plays other variations
+
+      // Starting over replays the same bars.
+      uint8_t first_pass[64];
+      a.Reset();
+      for (int t = 0; t < 64; ++t, a.TickClock(true))
+        first_pass[t] = a.get_trigger_state();
+      a.Reset();
+      for (int t = 0; t < 64; ++t, a.TickClock(true))
+        CHECK(a.get_trigger_state() == first_pass[t]);
+    }
+  }
+
+  TEST_CASE("Random words are evenly distributed over positions and seeds")
+  {
+    nt_grids_port::Random random;
+    uint32_t bit_counts[32] = {0};
+    uint32_t byte_histogram[4] = {0};
+    const int num_samples = 3 * 32 * 512;
+    for (uint32_t seed = 0; seed < 2; ++seed)
+    {
+      random.Seed(seed);
+      for (uint32_t bar = 0; bar < 512; ++bar)
+        for (uint8_t step = 0; step < 32; ++step)
+          for (uint8_t part = 0; part < 3; ++part)
+          {
+            uint32_t word = random.GetWord(bar, step, part);
+            CHECK(word == random.GetWord(bar, step, part));
+            for (int bit = 0; bit < 32; ++bit)
+              bit_counts[bit] += (word >> bit) & 1u;
+            byte_histogram[random.GetByte(bar, step, part) >> 6]++;
+          }
+    }
+    for (int bit = 0; bit < 32; ++bit)
+    {
+      CAPTURE(bit);
+      CHECK(bit_counts[bit] > num_samples * 2 * 49 / 100);
+      CHECK(bit_counts[bit] < num_samples * 2 * 51 / 100);
+    }
+    for (int q = 0; q < 4; ++q)
+      CHECK(byte_histogram[q] > num_samples * 2 / 4 * 97 / 100);
+  }
+
+  TEST_CASE("Per-bar Euclidean chaos keeps the per-step probabilities")
+  {
+    // The per-step chaos this replaced drew one 16-bit word per part and step: bits 0-7 gated
+    // the part (< amount), then bits 8-10 == 0 flipped it and, above 192, bits 11-14 == 0
+    // accented it. Enumerating every word gives its exact probabilities; the per-bar masks
+    // must match them within 5 sigma over many bars. Flips are counted against the same
+    // pattern played without chaos.
+    const int amounts[] = {1, 64, 192, 193, 255};
+    const int num_bars = 3000;
+    for (int a = 0; a < 5; ++a)
+    {
+      int amount = amounts[a];
+      int old_flips = 0, old_accents = 0;
+      for (int word = 0; word < 65536; ++word)
+      {
+        bool gate = (word & 0xff) < amount;
+        old_flips += gate && ((word >> 8) & 7) == 0;
+        old_accents += gate && amount > 192 && ((word >> 11) & 15) == 0;
+      }
+      double p_flip = old_flips / 65536.0;
+      double p_part_accent = old_accents / 65536.0;
+      double p_accent = 1.0 - (1.0 - p_part_accent) * (1.0 - p_part_accent) * (1.0 - p_part_accent); // Any part
+
+      PatternGenerator generator, clean;
+      PatternGenerator *generators[2] = {&generator, &clean};
+      for (int g = 0; g < 2; ++g)
+      {
+        generators[g]->set_output_mode(OUTPUT_MODE_EUCLIDEAN);
+        generators[g]->set_global_chaos(g == 0);
+        generators[g]->settings_[OUTPUT_MODE_EUCLIDEAN].options.euclidean.chaos_amount = (uint8_t)amount;
+        for (int p = 0; p < nt_grids_port::kNumParts; ++p)
+        {
+          generators[g]->SetLength((uint8_t)p, (uint8_t)(13 + p * 7));
+          generators[g]->SetFill((uint8_t)p, (uint8_t)(4 + p));
+        }
+        generators[g]->set_seed(99u);
+        generators[g]->Reset();
+      }
+
+      int flips[3] = {0, 0, 0};
+      int accents = 0;
+      const int n = num_bars * 32;
+      for (int t = 0; t < n; ++t)
+      {
+        uint8_t state = generator.get_trigger_state();
+        uint8_t flipped = state ^ clean.get_trigger_state();
+        for (int p = 0; p < 3; ++p)
+          flips[p] += (flipped >> p) & 1;
+        accents += (state >> 3) & 1;
+        generator.TickClock(true);
+        clean.TickClock(true);
+      }
+
+      CAPTURE(amount);
+      double sigma_flip = std::sqrt(n * p_flip * (1.0 - p_flip));
+      for (int p = 0; p < 3; ++p)
+      {
+        CAPTURE(p);
+        CHECK(std::fabs(flips[p] - n * p_flip) <= 5.0 * sigma_flip + 1.0);
+      }
+      double sigma_accent = std::sqrt(n * p_accent * (1.0 - p_accent));
+      CHECK(std::fabs(accents - n * p_accent) <= 5.0 * sigma_accent + 1.0);
+      CHECK((amount > 192 || accents == 0));
+    }
+  }
+
+  TEST_CASE("Lookahead plays what direct evaluation plays")
+  {
+    const nt_grids_port::grids::OutputMode modes[2] = {OUTPUT_MODE_DRUMS, OUTPUT_MODE_EUCLIDEAN};
+    for (int m = 0; m < 2; ++m)
+    {
+      for (int original_clocking = 0; original_clocking < 2; ++original_clocking)
+      {
+        CAPTURE(m);
+        CAPTURE(original_clocking);
+        PatternGenerator buffered, direct;
+        PatternGenerator *generators[2] = {&buffered, &direct};
+        for (int g = 0; g < 2; ++g)
+        {
+          generators[g]->set_output_mode(modes[m]);
+          generators[g]->set_original_grids_clocking(original_clocking != 0);
+          generators[g]->set_global_chaos(true);
+          set_drums(*generators[g], 90, 30, 160, 100, 220, 200);
+          generators[g]->settings_[OUTPUT_MODE_EUCLIDEAN].options.euclidean.chaos_amount = 230;
+          generators[g]->SetLength(0, 5);
+          generators[g]->SetLength(1, 13);
+          generators[g]->SetLength(2, 32);
+          generators[g]->PrepareDrumLevels();
+          generators[g]->Reset();
+        }
+
+        for (int t = 0; t < 400; ++t)
+        {
+          buffered.FillLookahead();
+          REQUIRE(buffered.lookahead_count() == nt_grids_port::grids::kLookaheadSteps);
+          if (t == 150)
+          {
+            // Change a setting mid-run: the setter must drop the stale steps.
+            buffered.SetFill(1, 9);
+            direct.SetFill(1, 9);
+            CHECK(buffered.lookahead_count() == 0);
+          }
+          buffered.TickClock(true);
+          direct.TickClock(true);
+          REQUIRE(buffered.step() == direct.step());
+          REQUIRE(buffered.get_trigger_state() == direct.get_trigger_state());
+          for (int p = 0; p < nt_grids_port::kNumParts; ++p)
+            REQUIRE(buffered.part_perturbation(p) == direct.part_perturbation(p));
+        }
+
+        // Peeking ahead shows exactly the steps that are about to play.
+        buffered.FillLookahead();
+        for (uint8_t k = 0; k < nt_grids_port::grids::kLookaheadSteps; ++k)
+        {
+          const nt_grids_port::grids::LookaheadEntry &entry = buffered.lookahead(k);
+          for (int tick = 0; tick < (original_clocking ? 3 : 1); ++tick)
+            direct.TickClock(true);
+          CHECK(entry.bar == direct.bar());
+          CHECK(entry.step == direct.step());
+          CHECK(entry.state == direct.get_trigger_state());
+        }
+      }
+    }
+  }
+
+  TEST_CASE("TopUpLookahead evaluates one step more than the ticks consumed")
+  {
+    PatternGenerator buffered, direct;
+    PatternGenerator *generators[2] = {&buffered, &direct};
+    for (int g = 0; g < 2; ++g)
+    {
+      generators[g]->set_global_chaos(true);
+      set_drums(*generators[g], 90, 30, 160, 100, 220, 200);
+      generators[g]->PrepareDrumLevels();
+      generators[g]->Reset();
+    }
+
+    buffered.TopUpLookahead(); // Nothing consumed yet: one step
+    CHECK(buffered.lookahead_count() == 1);
+    buffered.TopUpLookahead();
+    CHECK(buffered.lookahead_count() == 2);
+
+    // Invalidated before every fill, as a density under CV does: each fill is about the steps
+    // played since the last one, never the whole buffer.
+    for (int t = 0; t < 100; ++t)
+    {
+      const int ticks = t % 4;
+      for (int k = 0; k < ticks; ++k)
+      {
+        buffered.TickClock(true);
+        direct.TickClock(true);
+        REQUIRE(buffered.get_trigger_state() == direct.get_trigger_state());
+      }
+      buffered.InvalidateLookahead();
+      buffered.TopUpLookahead();
+      REQUIRE(buffered.lookahead_count() == ticks + 1);
+    }
+
+    // Left alone, the buffer grows back to full and stays full.
+    for (int t = 0; t < nt_grids_port::grids::kLookaheadSteps; ++t)
+      buffered.TopUpLookahead();
+    REQUIRE(buffered.lookahead_count() == nt_grids_port::grids::kLookaheadSteps);
+    for (int t = 0; t < 40; ++t)
+    {
+      buffered.TickClock(true);
+      direct.TickClock(true);
+      REQUIRE(buffered.get_trigger_state() == direct.get_trigger_state());
+      buffered.TopUpLookahead();
+      REQUIRE(buffered.lookahead_count() == nt_grids_port::grids::kLookaheadSteps);
+    }
+  }
+
+  TEST_CASE("RenderSteps on a const generator builds stale drum tables locally")
+  {
+    PatternGenerator generator;
+    set_drums(generator, 30, 200, 150, 90, 240, 0);
+    generator.PrepareDrumLevels();
+    set_drums(generator, 220, 40, 150, 90, 240, 0); // Written without PrepareDrumLevels()
+
+    const int count = 32;
+    uint8_t states[count];
+    const PatternGenerator &reader = generator;
+    reader.RenderSteps(generator.PositionAt(0, 0), count, states);
+
+    PatternGenerator fresh;
+    set_drums(fresh, 220, 40, 150, 90, 240, 0);
+    fresh.PrepareDrumLevels();
+    uint8_t fresh_states[count];
+    fresh.RenderSteps(fresh.PositionAt(0, 0), count, fresh_states);
+    for (int n = 0; n < count; ++n)
+    {
+      CAPTURE(n);
+      CHECK(states[n] == fresh_states[n]);
+    }
+  }
+
+  TEST_CASE("RenderSteps matches ticking and leaves the sequence alone")
+  {
+    const nt_grids_port::grids::OutputMode modes[2] = {OUTPUT_MODE_DRUMS, OUTPUT_MODE_EUCLIDEAN};
+    for (int m = 0; m < 2; ++m)
+    {
+      for (int original_clocking = 0; original_clocking < 2; ++original_clocking)
+      {
+        CAPTURE(m);
+        CAPTURE(original_clocking);
+        PatternGenerator generator;
+        generator.set_output_mode(modes[m]);
+        generator.set_original_grids_clocking(original_clocking != 0);
+        generator.set_global_chaos(true);
+        set_drums(generator, 180, 70, 150, 90, 240, 160);
+        generator.settings_[OUTPUT_MODE_EUCLIDEAN].options.euclidean.chaos_amount = 210;
+        generator.SetLength(0, 7);
+        generator.SetLength(1, 12);
+        generator.SetShift(2, 3);
+        generator.Reset();
+        for (int t = 0; t < 45 * (original_clocking ? 3 : 1); ++t)
+          generator.TickClock(true); // Start mid-bar
+
+        const int count = 80; // Crosses two bar lines
+        uint8_t states[count];
+        uint8_t levels[count][nt_grids_port::kNumParts];
+        nt_grids_port::grids::StepPosition start = generator.position();
+        generator.FillLookahead();
+        uint8_t state_before = generator.get_trigger_state();
+        const PatternGenerator &reader = generator; // RenderSteps is const
+        reader.RenderSteps(start, count, states, levels);
+        CHECK(generator.get_trigger_state() == state_before);
+        CHECK(generator.step() == start.step);
+        CHECK(generator.bar() == start.bar);
+        CHECK(generator.lookahead_count() == nt_grids_port::grids::kLookaheadSteps);
+
+        for (int n = 0; n < count; ++n)
+        {
+          CAPTURE(n);
+          REQUIRE(states[n] == generator.get_trigger_state());
+          for (int p = 0; p < nt_grids_port::kNumParts; ++p)
+          {
+            if (modes[m] == OUTPUT_MODE_DRUMS)
+            {
+              // The level is what the density threshold is applied to.
+              uint8_t density = generator.settings_[OUTPUT_MODE_DRUMS].density[p];
+              CHECK(((states[n] >> p) & 1) == (levels[n][p] > (uint8_t)~density && density != 0));
+            }
+            else
+            {
+              CHECK((levels[n][p] == 0 || levels[n][p] == 255));
+            }
+          }
+          for (int tick = 0; tick < (original_clocking ? 3 : 1); ++tick)
+            generator.TickClock(true);
+        }
+      }
+    }
+  }
+
+  TEST_CASE("Seek lands where replaying the ticks does")
+  {
+    const nt_grids_port::grids::OutputMode modes[2] = {OUTPUT_MODE_DRUMS, OUTPUT_MODE_EUCLIDEAN};
+    const uint32_t bars[] = {0, 1, 3, 7, 30};
+    const uint8_t steps[] = {0, 1, 2, 17, 31};
+    const uint8_t lengths[] = {32, 27};
+    for (int m = 0; m < 2; ++m)
+    {
+      for (int c = 0; c < 4; ++c)
+      {
+        const int original_clocking = c & 1;
+        const uint8_t length = lengths[c >> 1];
+        PatternGenerator replayed, sought;
+        PatternGenerator *generators[2] = {&replayed, &sought};
+        for (int g = 0; g < 2; ++g)
+        {
+          generators[g]->set_output_mode(modes[m]);
+          generators[g]->set_original_grids_clocking(original_clocking != 0);
+          generators[g]->set_global_chaos(true);
+          set_drums(*generators[g], 40, 220, 200, 130, 170, 255);
+          generators[g]->settings_[OUTPUT_MODE_EUCLIDEAN].options.euclidean.chaos_amount = 240;
+          generators[g]->SetLength(0, 3);
+          generators[g]->SetLength(1, 11);
+          generators[g]->SetLength(2, 32);
+          generators[g]->SetFill(1, 5);
+          generators[g]->SetPatternLength(length);
+        }
+        const int ticks_per_step = original_clocking ? 3 : 1;
+
+        for (int b = 0; b < 5; ++b)
+        {
+          for (int s = 0; s < 5; ++s)
+          {
+            CAPTURE(m);
+            CAPTURE(original_clocking);
+            CAPTURE((int)length);
+            CAPTURE(bars[b]);
+            CAPTURE((int)steps[s]);
+            const uint8_t step = steps[s] % length;
+            // Brute force: reset and tick all the way there.
+            replayed.Reset();
+            uint32_t ticks = (bars[b] * length + step) * ticks_per_step;
+            for (uint32_t t = 0; t < ticks; ++t)
+              replayed.TickClock(true);
+
+            sought.TickClock(true); // Wherever it was before
+            sought.Seek(bars[b], step);
+
+            nt_grids_port::grids::StepPosition expected = replayed.position();
+            nt_grids_port::grids::StepPosition got = sought.position();
+            REQUIRE(got.bar == expected.bar);
+            REQUIRE(got.step == expected.step);
+            for (int p = 0; p < nt_grids_port::kNumParts; ++p)
+              REQUIRE(got.euclidean_step[p] == expected.euclidean_step[p]);
+            CHECK(sought.get_trigger_state() == replayed.get_trigger_state());
+            CHECK(sought.on_first_beat() == replayed.on_first_beat());
+            CHECK(sought.on_beat() == replayed.on_beat());
+            for (int p = 0; p < nt_grids_port::kNumParts; ++p)
+              CHECK(sought.part_perturbation(p) == replayed.part_perturbation(p));
+
+            // And both continue identically.
+            for (int t = 0; t < 40 * ticks_per_step; ++t)
+            {
+              replayed.TickClock(true);
+              sought.TickClock(true);
+              REQUIRE(sought.get_trigger_state() == replayed.get_trigger_state());
+            }
+          }
+        }
+      }
+    }
+  }
+
+  TEST_CASE("Clock resolution sets the steps per tick and a change keeps the position")
+  {
+    using nt_grids_port::grids::CLOCK_RESOLUTION_4_PPQN;
+    using nt_grids_port::grids::CLOCK_RESOLUTION_8_PPQN;
+    using nt_grids_port::grids::CLOCK_RESOLUTION_24_PPQN;
+
+    PatternGenerator generator, reference;
+    PatternGenerator *generators[2] = {&generator, &reference};
+    for (int g = 0; g < 2; ++g)
+    {
+      set_drums(*generators[g], 40, 220, 200, 130, 170, 0);
+      generators[g]->SetPatternLength(28);
+      generators[g]->Reset();
+      generators[g]->FillLookahead();
+    }
+    CHECK(generator.current_clock_resolution() == CLOCK_RESOLUTION_8_PPQN);
+
+    // 24 PPQN: three ticks per step.
+    generator.set_clock_resolution(CLOCK_RESOLUTION_24_PPQN);
+    for (int step = 1; step <= 40; ++step)
+    {
+      for (int t = 0; t < 3; ++t)
+      {
+        CHECK(generator.step() == (step - 1) % 28);
+        generator.TickClock(true);
+      }
+      reference.TickClock(true);
+      REQUIRE(generator.step() == reference.step());
+      REQUIRE(generator.bar() == reference.bar());
+      REQUIRE(generator.get_trigger_state() == reference.get_trigger_state());
+    }
+
+    // Two pulses into a step, switching to 8 PPQN keeps the step and the pulses: the next
+    // tick (three pulses) plays the next step and leaves two towards the one after.
+    generator.TickClock(true);
+    generator.TickClock(true);
+    const uint8_t step = generator.step();
+    const uint32_t bar = generator.bar();
+    generator.set_clock_resolution(CLOCK_RESOLUTION_8_PPQN);
+    CHECK(generator.step() == step);
+    CHECK(generator.bar() == bar);
+    generator.TickClock(true);
+    reference.TickClock(true);
+    CHECK(generator.step() == reference.step());
+    generator.set_clock_resolution(CLOCK_RESOLUTION_24_PPQN);
+    generator.TickClock(true); // Completes the two pulses carried over
+    reference.TickClock(true);
+    CHECK(generator.step() == reference.step());
+
+    // 4 PPQN: two steps per tick, playing the second, with or without the lookahead.
+    generator.set_clock_resolution(CLOCK_RESOLUTION_4_PPQN);
+    for (int tick = 0; tick < 40; ++tick)
+    {
+      CAPTURE(tick);
+      if (tick & 1)
+      {
+        generator.FillLookahead();
+        reference.FillLookahead();
+      }
+      generator.TickClock(true);
+      reference.TickClock(true);
+      reference.TickClock(true);
+      REQUIRE(generator.step() == reference.step());
+      REQUIRE(generator.bar() == reference.bar());
+      REQUIRE(generator.get_trigger_state() == reference.get_trigger_state());
+    }
+  }
+
+  TEST_CASE("Pattern length wraps the bar and moves the beats")
+  {
+    const uint8_t lengths[] = {24, 28, 7, 1, 32};
+    for (int l = 0; l < 5; ++l)
+    {
+      CAPTURE((int)lengths[l]);
+      PatternGenerator full, truncated;
+      PatternGenerator *generators[2] = {&full, &truncated};
+      for (int g = 0; g < 2; ++g)
+      {
+        generators[g]->set_output_mode(OUTPUT_MODE_DRUMS);
+        generators[g]->set_global_chaos(true);
+        set_drums(*generators[g], 70, 30, 220, 190, 240, 200);
+      }
+      truncated.SetPatternLength(lengths[l]);
+      CHECK(truncated.pattern_length() == lengths[l]);
+      truncated.Reset();
+
+      // Each bar plays the first `length` steps of the same bar at full length, chaos included.
+      for (uint32_t bar = 0; bar < 4; ++bar)
+      {
+        full.Seek(bar, 0);
+        for (int s = 0; s < lengths[l]; ++s)
+        {
+          CAPTURE(bar);
+          CAPTURE(s);
+          REQUIRE(truncated.bar() == bar);
+          REQUIRE(truncated.step() == s);
+          CHECK(truncated.get_trigger_state() == full.get_trigger_state());
+          CHECK(truncated.on_first_beat() == (s == 0));
+          CHECK(truncated.on_beat() == (s % 8 == 0));
+          truncated.TickClock(true);
+          full.TickClock(true);
+        }
+      }
+    }
+
+    // Shortening the length while past it wraps on the next step.
+    PatternGenerator generator;
+    generator.Seek(0, 30);
+    generator.SetPatternLength(24);
+    generator.TickClock(true);
+    CHECK(generator.step() == 0);
+    CHECK(generator.bar() == 1u);
+    CHECK(generator.on_first_beat());
+  }
+
+  TEST_CASE("A 4-part, 64-step variant reuses the drum map and widens the masks")
+  {
+    typedef nt_grids_port::grids::BasicPatternGenerator<4, 64> WideGenerator;
+    WideGenerator wide;
+    PatternGenerator narrow;
+    CHECK(sizeof(WideGenerator::StepMask) == 8);
+
+    // Chaos off: steps 32-63 replay the map's 32 steps, part 4 replays part 1, and the accent
+    // moves up to bit 4.
+    const uint8_t x = 90, y = 170, densities[4] = {200, 150, 230, 200};
+    set_drums(narrow, x, y, densities[0], densities[1], densities[2], 0);
+    wide.settings_[OUTPUT_MODE_DRUMS].options.drums.x = x;
+    wide.settings_[OUTPUT_MODE_DRUMS].options.drums.y = y;
+    wide.settings_[OUTPUT_MODE_DRUMS].options.drums.randomness = 0;
+    for (int p = 0; p < 4; ++p)
+      wide.settings_[OUTPUT_MODE_DRUMS].density[p] = densities[p];
+    narrow.set_output_mode(OUTPUT_MODE_DRUMS);
+    wide.set_output_mode(OUTPUT_MODE_DRUMS);
+
+    uint8_t narrow_states[32], wide_states[64];
+    narrow.RenderSteps(narrow.PositionAt(0, 0), 32, narrow_states);
+    wide.RenderSteps(wide.PositionAt(0, 0), 64, wide_states);
+    for (int s = 0; s < 64; ++s)
+    {
+      uint8_t expected = narrow_states[s & 31];
+      expected = (uint8_t)((expected & 7) | ((expected & 1) << 3) | ((expected & OUTPUT_BIT_ACCENT) << 1));
+      CHECK(wide_states[s] == expected);
+    }
+
+    // Ticking covers all 64 steps before the bar wraps.
+    wide.Reset();
+    for (int s = 1; s < 64; ++s)
+    {
+      wide.TickClock(true);
+      CHECK(wide.step() == s);
+      CHECK(wide.bar() == 0u);
+    }
+    wide.TickClock(true);
+    CHECK(wide.step() == 0);
+    CHECK(wide.bar() == 1u);
+
+    // Euclidean chaos flips steps in the upper half of the 64-bit masks too.
+    wide.set_output_mode(OUTPUT_MODE_EUCLIDEAN);
+    wide.settings_[OUTPUT_MODE_EUCLIDEAN].options.euclidean.chaos_amount = 255;
+    wide.set_global_chaos(true);
+    WideGenerator clean;
+    clean.set_output_mode(OUTPUT_MODE_EUCLIDEAN);
+    int upper_flips = 0;
+    for (uint32_t bar = 0; bar < 16; ++bar)
+    {
+      wide.RenderSteps(wide.PositionAt(bar, 0), 64, wide_states);
+      uint8_t clean_states[64];
+      clean.RenderSteps(clean.PositionAt(bar, 0), 64, clean_states);
+      for (int s = 32; s < 64; ++s)
+        upper_flips += ((wide_states[s] ^ clean_states[s]) & 0x0f) != 0;
+    }
+    CHECK(upper_flips > 0);
+  }
+
+  // Skipped by default: run with `-ts="Pattern generator" --no-skip`.
+  TEST_CASE("Benchmark: RenderSteps vs ticking a bar" * doctest::skip())
+  {
+    PatternGenerator generator;
+    generator.set_output_mode(OUTPUT_MODE_DRUMS);
+    set_drums(generator, 100, 200, 180, 120, 200, 64);
+    generator.set_global_chaos(true);
+    generator.Reset();
+    const int bars = 20000;
+    uint8_t states[nt_grids_port::kStepsPerPattern];
+    volatile uint32_t sink = 0;
+
+    typedef std::chrono::steady_clock clk;
+    clk::time_point t0 = clk::now();
+    for (int b = 0; b < bars; ++b)
+    {
+      for (int s = 0; s < nt_grids_port::kStepsPerPattern; ++s)
+      {
+        generator.TickClock(true);
+        sink += generator.get_trigger_state();
+      }
+    }
+    clk::time_point t1 = clk::now();
+    nt_grids_port::grids::StepPosition start = generator.position();
+    for (int b = 0; b < bars; ++b)
+    {
+      start.bar = (uint32_t)b;
+      generator.RenderSteps(start, nt_grids_port::kStepsPerPattern, states);
+      sink += states[b & 31];
+    }
+    clk::time_point t2 = clk::now();
+
+    double tick_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / bars;
+    double render_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / bars;
+    MESSAGE("32 steps by TickClock: " << tick_ns << " ns, RenderSteps: " << render_ns << " ns (drums, chaos on)");
+    CHECK(sink != 0);
+  }
+}
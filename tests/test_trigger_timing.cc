@@ -0,0 +1,778 @@
+#include "doctest.h"
+#include "nt_grids_test_host.h"
+#include "nt_grids_pattern_generator.h"
+
+#include <vector>
+
+// Bus layout used by these tests (bus parameter values are 1-based).
+static const int kClockBus = 0;
+static const int kFirstOutputBus = 14;
+static const int kNumBuses = 28;
+
+static void route_outputs_replace(NtGridsTestHost &host)
+{
+  host.setParameter(kParamClockInput, kClockBus + 1);
+  host.setParameter(kParamResetInput, 0);
+  const ParameterIndex outputs[4] = {kParamOutputTrig1, kParamOutputTrig2, kParamOutputTrig3, kParamOutputAccent};
+  for (int i = 0; i < 4; ++i)
+  {
+    host.setParameter(outputs[i], kFirstOutputBus + i + 1);
+    host.setParameter((ParameterIndex)(outputs[i] + 1), 1); // Replace
+  }
+  // Full density so the downbeat fires every part.
+  host.setParameter(kParamDrumDensity1, 255);
+  host.setParameter(kParamDrumDensity2, 255);
+  host.setParameter(kParamDrumDensity3, 255);
+}
+
+// Clocks the pattern forward so the next edge lands on the downbeat (step 0), then
+// runs enough idle blocks for every trigger started by the priming edges to finish.
+static void advance_to_downbeat(NtGridsTestHost &host, int numFramesBy4)
+{
+  std::vector<float> bus(kNumBuses * 4, 0.0f);
+  for (int i = 0; i < nt_grids_port::kStepsPerPattern - 1; ++i)
+  {
+    bus[kClockBus * 4 + 0] = 5.0f;
+    bus[kClockBus * 4 + 1] = 5.0f;
+    bus[kClockBus * 4 + 2] = 0.0f;
+    bus[kClockBus * 4 + 3] = 0.0f;
+    host.step(bus, 1);
+  }
+  // Longest trigger length parameter is 100 ms.
+  const int idle_samples = (int)NT_globals.sampleRate / 10 + 1;
+  std::vector<float> idle(kNumBuses * numFramesBy4 * 4, 0.0f);
+  for (int i = 0; i * numFramesBy4 * 4 < idle_samples; ++i)
+  {
+    host.step(idle, numFramesBy4);
+  }
+}
+
+// Trig 1 onsets expected when the pattern is ticked `tick_counts[k]` times at sample
+// `tick_samples[k]`: the state after each group of ticks that played a step, from a generator
+// ticked directly.
+static std::vector<int> expected_trig1_onsets(const std::vector<int> &tick_samples, const std::vector<int> &tick_counts)
+{
+  NtGridsTestHost reference;
+  route_outputs_replace(reference);
+  nt_grids_port::grids::PatternGenerator &generator = reference.algorithm->pattern_generator;
+  std::vector<int> onsets;
+  for (size_t k = 0; k < tick_samples.size(); ++k)
+  {
+    bool stepped = false;
+    for (int t = 0; t < tick_counts[k]; ++t)
+    {
+      stepped |= generator.TickClock(true);
+    }
+    if (stepped && (generator.get_trigger_state() & nt_grids_port::grids::OUTPUT_BIT_TRIG_1))
+      onsets.push_back(tick_samples[k]);
+  }
+  return onsets;
+}
+
+// Appends the samples of block `block` (n frames) where Trig 1 rises; `previous` carries the
+// last sample of the previous block.
+static void collect_trig1_onsets(const std::vector<float> &bus, int n, int block, float *previous,
+                                 std::vector<int> *onsets)
+{
+  const float *trig1 = &bus[kFirstOutputBus * n];
+  for (int s = 0; s < n; ++s)
+  {
+    if (*previous == 0.0f && trig1[s] == 5.0f)
+      onsets->push_back(block * n + s);
+    *previous = trig1[s];
+  }
+}
+
+TEST_SUITE("Trigger timing")
+{
+  TEST_CASE("Trigger rises on the sample of the clock edge for every block size")
+  {
+    const uint8_t output_bits[4] = {
+        nt_grids_port::grids::OUTPUT_BIT_TRIG_1, nt_grids_port::grids::OUTPUT_BIT_TRIG_2,
+        nt_grids_port::grids::OUTPUT_BIT_TRIG_3, nt_grids_port::grids::OUTPUT_BIT_ACCENT};
+
+    for (int numFramesBy4 = 1; numFramesBy4 * 4 <= (int)NT_globals.maxFramesPerStep; ++numFramesBy4)
+    {
+      const int n = numFramesBy4 * 4;
+      for (int edge = 0; edge < n; ++edge)
+      {
+        CAPTURE(n);
+        CAPTURE(edge);
+        NtGridsTestHost host;
+        route_outputs_replace(host);
+
+        advance_to_downbeat(host, numFramesBy4);
+
+        std::vector<float> bus(kNumBuses * n, 0.0f);
+
+        for (int s = 0; s < n; ++s)
+        {
+          bus[kClockBus * n + s] = (s >= edge) ? 5.0f : 0.0f;
+        }
+        host.step(bus, numFramesBy4);
+
+        uint8_t state = host.algorithm->pattern_generator.get_trigger_state();
+        REQUIRE((state & 0x7) != 0);
+        for (int i = 0; i < 4; ++i)
+        {
+          const float *out = &bus[(kFirstOutputBus + i) * n];
+          bool fires = (state & output_bits[i]) != 0;
+          int first_high = n;
+          for (int s = 0; s < n; ++s)
+          {
+            if (out[s] > 0.0f)
+            {
+              first_high = s;
+              break;
+            }
+          }
+          CHECK(first_high == (fires ? edge : n));
+          for (int s = first_high; s < n; ++s)
+          {
+            CHECK(out[s] == 5.0f);
+          }
+        }
+      }
+    }
+  }
+
+  TEST_CASE("Trigger width matches the length parameter at every block size")
+  {
+    const int lengths_ms[] = {1, 5, 17};
+    for (int l = 0; l < 3; ++l)
+    {
+      for (int numFramesBy4 = 1; numFramesBy4 * 4 <= (int)NT_globals.maxFramesPerStep; numFramesBy4 *= 2)
+      {
+        const int n = numFramesBy4 * 4;
+        const int edge = n / 2 + 1;
+        CAPTURE(lengths_ms[l]);
+        CAPTURE(n);
+        NtGridsTestHost host;
+        route_outputs_replace(host);
+        host.setParameter(kParamTrig1Length, lengths_ms[l]);
+        advance_to_downbeat(host, numFramesBy4);
+
+        const int expected = (int)(lengths_ms[l] * NT_globals.sampleRate / 1000);
+        std::vector<float> bus(kNumBuses * n, 0.0f);
+        std::vector<float> trig1; // Concatenated Trig 1 output across blocks
+        for (int block = 0; block * n < expected + 2 * n; ++block)
+        {
+          for (int s = 0; s < n; ++s)
+          {
+            bus[kClockBus * n + s] = (block == 0 && s >= edge) ? 5.0f : 0.0f;
+          }
+          host.step(bus, numFramesBy4);
+          trig1.insert(trig1.end(), &bus[kFirstOutputBus * n], &bus[kFirstOutputBus * n] + n);
+        }
+
+        REQUIRE((host.algorithm->pattern_generator.get_trigger_state() & nt_grids_port::grids::OUTPUT_BIT_TRIG_1) != 0);
+        int high = 0;
+        int first_high = -1;
+        for (size_t s = 0; s < trig1.size(); ++s)
+        {
+          if (trig1[s] > 0.0f)
+          {
+            if (first_high < 0)
+              first_high = (int)s;
+            ++high;
+          }
+        }
+        CHECK(first_high == edge);
+        CHECK(high == expected);
+        CHECK(trig1[edge + expected - 1] == 5.0f);
+        CHECK(trig1[edge + expected] == 0.0f);
+      }
+    }
+  }
+
+  TEST_CASE("A trigger longer than the tick spacing still rises on every hit")
+  {
+    const int numFramesBy4 = 8;
+    const int n = numFramesBy4 * 4;
+    const int periods[2] = {150, 160}; // Edges mid-block, and edges on the first sample of a block
+    const int num_edges = 40;
+    for (int c = 0; c < 2; ++c)
+    {
+      const int period = periods[c];
+      CAPTURE(period);
+      NtGridsTestHost host;
+      route_outputs_replace(host);
+      host.setParameter(kParamTrig1Length, 20); // 960 samples, six ticks or so
+
+      std::vector<float> bus(kNumBuses * n, 0.0f);
+      std::vector<int> onsets;
+      float previous = 0.0f;
+      for (int block = 0; block * n < num_edges * period; ++block)
+      {
+        for (int s = 0; s < n; ++s)
+        {
+          bus[kClockBus * n + s] = ((block * n + s) % period < 10) ? 5.0f : 0.0f;
+        }
+        host.step(bus, numFramesBy4);
+        collect_trig1_onsets(bus, n, block, &previous, &onsets);
+      }
+
+      // A hit while the trigger is high ends it a sample early; where that sample belongs to the
+      // previous block, the new trigger rises a sample late instead.
+      std::vector<int> tick_samples, tick_counts;
+      for (int k = 0; k < num_edges; ++k)
+      {
+        tick_samples.push_back(k * period);
+        tick_counts.push_back(1);
+      }
+      const std::vector<int> expected = expected_trig1_onsets(tick_samples, tick_counts);
+      REQUIRE(expected.size() >= 10);
+      REQUIRE(onsets.size() == expected.size());
+      for (size_t k = 0; k < expected.size(); ++k)
+      {
+        CAPTURE(k);
+        const bool late = k > 0 && expected[k] % n == 0 && expected[k] - expected[k - 1] <= 960;
+        CHECK(onsets[k] == expected[k] + (late ? 1 : 0));
+      }
+    }
+  }
+
+  TEST_CASE("Every tick in a block plays its own step")
+  {
+    const int numFramesBy4 = 32;
+    const int n = numFramesBy4 * 4;
+    const int ticks_per_block = 2;
+    const int period = n / ticks_per_block;
+    const int num_ticks = nt_grids_port::kStepsPerPattern;
+
+    // Reference: one tick per block, reading the generator state after each tick.
+    uint8_t expected_states[nt_grids_port::kStepsPerPattern + 1];
+    {
+      NtGridsTestHost host;
+      route_outputs_replace(host);
+      std::vector<float> bus(kNumBuses * n, 0.0f);
+      for (int t = 0; t <= num_ticks; ++t)
+      {
+        for (int s = 0; s < n; ++s)
+        {
+          bus[kClockBus * n + s] = (s < period / 2) ? 5.0f : 0.0f;
+        }
+        host.step(bus, numFramesBy4);
+        expected_states[t] = host.algorithm->pattern_generator.get_trigger_state();
+      }
+    }
+
+    // One lone tick first so the pairs that follow start on even (busier) steps, then two
+    // ticks per block. The 1 ms triggers are shorter than the tick period so each onset is visible.
+    NtGridsTestHost host;
+    route_outputs_replace(host);
+    for (int i = 0; i < 4; ++i)
+    {
+      host.setParameter((ParameterIndex)(kParamTrig1Length + i), 1);
+    }
+    std::vector<float> bus(kNumBuses * n, 0.0f);
+    for (int s = 0; s < n; ++s)
+    {
+      bus[kClockBus * n + s] = (s < period / 2) ? 5.0f : 0.0f;
+    }
+    host.step(bus, numFramesBy4);
+
+    float previous[4];
+    for (int i = 0; i < 4; ++i)
+    {
+      previous[i] = bus[(kFirstOutputBus + i) * n + n - 1];
+    }
+    int tick = 1;
+    for (int block = 0; block < num_ticks / ticks_per_block; ++block)
+    {
+      for (int s = 0; s < n; ++s)
+      {
+        bus[kClockBus * n + s] = ((s % period) < period / 2) ? 5.0f : 0.0f;
+      }
+      host.step(bus, numFramesBy4);
+      for (int k = 0; k < ticks_per_block; ++k, ++tick)
+      {
+        const int onset = k * period;
+        for (int i = 0; i < 4; ++i)
+        {
+          const float *out = &bus[(kFirstOutputBus + i) * n];
+          const uint8_t bit = (i < 3) ? (1 << i) : nt_grids_port::grids::OUTPUT_BIT_ACCENT;
+          float before = (onset == 0) ? previous[i] : out[onset - 1];
+          bool rose = before == 0.0f && out[onset] == 5.0f;
+          CAPTURE(tick);
+          CAPTURE(i);
+          CHECK(rose == ((expected_states[tick] & bit) != 0));
+        }
+      }
+      for (int i = 0; i < 4; ++i)
+      {
+        previous[i] = bus[(kFirstOutputBus + i) * n + n - 1];
+      }
+    }
+  }
+
+  TEST_CASE("Every step and output kernel renders what Replace mode renders")
+  {
+    const int numFramesBy4 = 16;
+    const int n = numFramesBy4 * 4;
+    const int kResetBus = 1;
+    const ParameterIndex outputs[4] = {kParamOutputTrig1, kParamOutputTrig2, kParamOutputTrig3, kParamOutputAccent};
+    for (int inputs = 0; inputs < 4; ++inputs)
+    {
+      const bool clock_routed = (inputs & 1) != 0;
+      const bool reset_routed = (inputs & 2) != 0;
+      for (int config = 0; config < 81; ++config) // Off, Add or Replace for each output
+      {
+        CAPTURE(inputs);
+        CAPTURE(config);
+        NtGridsTestHost reference, host;
+        NtGridsTestHost *hosts[2] = {&reference, &host};
+        int modes[4];
+        for (int i = 0, c = config; i < 4; ++i, c /= 3)
+          modes[i] = c % 3;
+        for (int h = 0; h < 2; ++h)
+        {
+          route_outputs_replace(*hosts[h]);
+          hosts[h]->setParameter(kParamClockInput, clock_routed ? kClockBus + 1 : 0);
+          hosts[h]->setParameter(kParamResetInput, reset_routed ? kResetBus + 1 : 0);
+        }
+        for (int i = 0; i < 4; ++i)
+        {
+          host.setParameter(outputs[i], modes[i] == 0 ? 0 : kFirstOutputBus + i + 1);
+          host.setParameter((ParameterIndex)(outputs[i] + 1), modes[i] == 2 ? 1 : 0);
+        }
+
+        for (int block = 0; block < 4; ++block)
+        {
+          std::vector<float> expected(kNumBuses * n, 1.25f), bus(kNumBuses * n, 1.25f);
+          for (int s = 0; s < n; ++s)
+          {
+            expected[kClockBus * n + s] = bus[kClockBus * n + s] = (s % 16 < 8) ? 5.0f : 0.0f;
+            expected[kResetBus * n + s] = bus[kResetBus * n + s] = (block == 2 && s >= 40) ? 5.0f : 0.0f;
+          }
+          reference.step(expected, numFramesBy4);
+          host.step(bus, numFramesBy4);
+          for (int i = 0; i < 4; ++i)
+          {
+            const float *want = &expected[(kFirstOutputBus + i) * n];
+            const float *got = &bus[(kFirstOutputBus + i) * n];
+            for (int s = 0; s < n; ++s)
+            {
+              float value = modes[i] == 0 ? 1.25f : (modes[i] == 1 ? 1.25f + want[s] : want[s]);
+              REQUIRE(got[s] == value);
+            }
+          }
+        }
+        CHECK(host.algorithm->pattern_generator.step() == reference.algorithm->pattern_generator.step());
+      }
+    }
+  }
+
+  TEST_CASE("At 24 PPQN only every third clock plays a step")
+  {
+    const int numFramesBy4 = 8;
+    const int n = numFramesBy4 * 4;
+    const int period = 160;
+    const int num_edges = 3 * 32; // One bar
+
+    NtGridsTestHost host;
+    route_outputs_replace(host);
+    host.setParameter(kParamTrig1Length, 1);
+    host.setParameter(kParamClockResolution, 2); // 24 PPQN
+
+    std::vector<int> onsets;
+    std::vector<float> bus(kNumBuses * n, 0.0f);
+    float previous = 0.0f;
+    for (int block = 0; block * n < num_edges * period; ++block)
+    {
+      for (int s = 0; s < n; ++s)
+      {
+        bus[kClockBus * n + s] = ((block * n + s) % period < 10) ? 5.0f : 0.0f;
+      }
+      host.step(bus, numFramesBy4);
+      collect_trig1_onsets(bus, n, block, &previous, &onsets);
+    }
+
+    // The same onsets as an 8 PPQN clock on every third edge, the one completing a step's three
+    // pulses: the clocks in between fire nothing.
+    std::vector<int> tick_samples, tick_counts;
+    for (int k = 2; k < num_edges; k += 3)
+    {
+      tick_samples.push_back(k * period);
+      tick_counts.push_back(1);
+    }
+    const std::vector<int> expected = expected_trig1_onsets(tick_samples, tick_counts);
+    REQUIRE(expected.size() >= 4);
+    CHECK(onsets == expected);
+    CHECK(host.algorithm->pattern_generator.bar() == 1);
+    CHECK(host.algorithm->pattern_generator.step() == 0);
+  }
+
+  TEST_CASE("Internal clock ticks on exact samples at every block size")
+  {
+    // 75 BPM at 8 ticks a beat is 10 ticks per second: one tick every 4800 samples at 48 kHz, the
+    // first on the last sample of the first period. Each tick plays a step.
+    const int period = (int)NT_globals.sampleRate / 10;
+    const int num_ticks = 8;
+    std::vector<int> tick_samples, tick_counts;
+    for (int k = 1; k <= num_ticks; ++k)
+    {
+      tick_samples.push_back(k * period - 1);
+      tick_counts.push_back(1);
+    }
+    const std::vector<int> expected = expected_trig1_onsets(tick_samples, tick_counts);
+    REQUIRE(expected.size() >= 2);
+
+    for (int numFramesBy4 = 1; numFramesBy4 * 4 <= (int)NT_globals.maxFramesPerStep; numFramesBy4 *= 2)
+    {
+      const int n = numFramesBy4 * 4;
+      CAPTURE(n);
+      NtGridsTestHost host;
+      route_outputs_replace(host);
+      host.setParameter(kParamTrig1Length, 1);
+      host.setParameter(kParamClockSource, 1); // Internal
+      host.setParameter(kParamTempo, 750);
+
+      std::vector<float> bus(kNumBuses * n, 0.0f);
+      std::vector<int> onsets;
+      float previous = 0.0f;
+      for (int block = 0; block * n < num_ticks * period; ++block)
+      {
+        for (int s = 0; s < n; ++s)
+        {
+          bus[kClockBus * n + s] = (s & 1) ? 5.0f : 0.0f; // Ignored under the internal clock
+        }
+        host.step(bus, numFramesBy4);
+        collect_trig1_onsets(bus, n, block, &previous, &onsets);
+      }
+      CHECK(onsets == expected);
+    }
+  }
+
+  TEST_CASE("Internal clock plays every step, eight a beat, at any Clock Resolution")
+  {
+    const int numFramesBy4 = 8;
+    const int n = numFramesBy4 * 4;
+    const int num_samples = (int)NT_globals.sampleRate + n * 16; // One second at 120 BPM, and a little
+    for (int resolution = 0; resolution < 3; ++resolution)
+    {
+      CAPTURE(resolution);
+      NtGridsTestHost host;
+      route_outputs_replace(host);
+      host.setParameter(kParamTrig1Length, 1);
+      host.setParameter(kParamClockSource, 1); // Internal
+      host.setParameter(kParamTempo, 1200);
+      host.setParameter(kParamClockResolution, resolution); // Only for the external clock
+
+      std::vector<float> bus(kNumBuses * n, 0.0f);
+      std::vector<int> onsets;
+      float previous = 0.0f;
+      for (int block = 0; block * n < num_samples; ++block)
+      {
+        host.step(bus, numFramesBy4);
+        collect_trig1_onsets(bus, n, block, &previous, &onsets);
+      }
+      // Two beats of eight steps, each tick playing its step
+      CHECK(host.algorithm->pattern_generator.bar() == 0);
+      CHECK(host.algorithm->pattern_generator.step() == 16);
+      std::vector<int> tick_samples, tick_counts;
+      for (int k = 1; k <= 16; ++k)
+      {
+        tick_samples.push_back(k * 3000 - 1);
+        tick_counts.push_back(1);
+      }
+      CHECK(onsets == expected_trig1_onsets(tick_samples, tick_counts));
+    }
+  }
+
+  TEST_CASE("Clock timeout freewheels at the tracked period and re-locks on the late edge")
+  {
+    const int numFramesBy4 = 8;
+    const int n = numFramesBy4 * 4;
+    const int period = 480;
+    const int last_before_loss = 7; // Edges 8 to 12 are missing
+    const int first_after_loss = 13;
+    const int num_edges = 40;
+    const int late = 5; // Samples the returning clock lags the freewheeled ticks by
+
+    NtGridsTestHost reference, host;
+    NtGridsTestHost *hosts[2] = {&reference, &host};
+    for (int h = 0; h < 2; ++h)
+    {
+      route_outputs_replace(*hosts[h]);
+      hosts[h]->setParameter(kParamTrig1Length, 1);
+    }
+    host.setParameter(kParamClockTimeout, 2);
+
+    std::vector<int> onsets;
+    std::vector<float> bus(kNumBuses * n, 0.0f), ref_bus(kNumBuses * n, 0.0f);
+    float previous = 0.0f;
+    for (int block = 0; block * n < num_edges * period; ++block)
+    {
+      for (int s = 0; s < n; ++s)
+      {
+        const int t = block * n + s;
+        const int k = t / period;
+        const int since = t - k * period - (k >= first_after_loss ? late : 0);
+        const bool high = since >= 0 && since < 10;
+        ref_bus[kClockBus * n + s] = high ? 5.0f : 0.0f;
+        bus[kClockBus * n + s] = (high && (k <= last_before_loss || k >= first_after_loss)) ? 5.0f : 0.0f;
+      }
+      reference.step(ref_bus, numFramesBy4);
+      host.step(bus, numFramesBy4);
+      collect_trig1_onsets(bus, n, block, &previous, &onsets);
+    }
+
+    // Real edges, then the two missed steps caught up when the timeout expires (on time for the
+    // second), then a tick a period; the late edge that stands for the last of these plays nothing.
+    std::vector<int> tick_samples, tick_counts;
+    for (int k = 0; k <= last_before_loss; ++k)
+    {
+      tick_samples.push_back(k * period);
+      tick_counts.push_back(1);
+    }
+    for (int k = last_before_loss + 2; k <= first_after_loss; ++k)
+    {
+      tick_samples.push_back(k * period);
+      tick_counts.push_back(k == last_before_loss + 2 ? 2 : 1);
+    }
+    for (int k = first_after_loss + 1; k < num_edges; ++k)
+    {
+      tick_samples.push_back(k * period + late);
+      tick_counts.push_back(1);
+    }
+    const std::vector<int> expected = expected_trig1_onsets(tick_samples, tick_counts);
+    REQUIRE(expected.size() >= 8);
+    CHECK(onsets == expected);
+    CHECK(host.algorithm->pattern_generator.step() == reference.algorithm->pattern_generator.step());
+    CHECK(host.algorithm->pattern_generator.bar() == reference.algorithm->pattern_generator.bar());
+    CHECK(!host.algorithm->clock_tracker.freewheeling);
+    CHECK((host.algorithm->clock_tracker.period_q4 + 8) / 16 == (uint32_t)period);
+  }
+
+  TEST_CASE("Clock timeout follows a clock that slows down")
+  {
+    const int numFramesBy4 = 8;
+    const int n = numFramesBy4 * 4;
+    const int fast = 480, slow = 1060; // More than twice as slow: every interval is freewheeled over
+    const int num_fast = 10, num_edges = 50;
+    std::vector<int> edges;
+    for (int k = 0; k < num_edges; ++k)
+      edges.push_back(k <= num_fast ? k * fast : num_fast * fast + (k - num_fast) * slow);
+
+    for (int timeout = 1; timeout <= 2; ++timeout)
+    {
+      CAPTURE(timeout);
+      NtGridsTestHost host;
+      route_outputs_replace(host);
+      host.setParameter(kParamClockTimeout, timeout);
+
+      std::vector<float> bus(kNumBuses * n, 0.0f);
+      size_t next_edge = 0;
+      long steps_at[2] = {0, 0};
+      const int measure_from = 40, measure_to = 49; // Edges, once the new period is tracked
+      for (int block = 0; block * n < edges.back() + slow / 2; ++block)
+      {
+        for (int s = 0; s < n; ++s)
+        {
+          const int t = block * n + s;
+          while (next_edge + 1 < edges.size() && edges[next_edge + 1] <= t)
+            ++next_edge;
+          bus[kClockBus * n + s] = (t >= edges[next_edge] && t - edges[next_edge] < 10) ? 5.0f : 0.0f;
+        }
+        host.step(bus, numFramesBy4);
+        const int end = (block + 1) * n;
+        const nt_grids_port::grids::PatternGenerator &generator = host.algorithm->pattern_generator;
+        for (int m = 0; m < 2; ++m)
+        {
+          const int at = edges[m ? measure_to : measure_from] + slow / 2;
+          if (end > at && end - n <= at)
+            steps_at[m] = (long)generator.bar() * generator.pattern_length() + generator.step();
+        }
+      }
+      // One step per real edge again, at the measured slower period.
+      CHECK(steps_at[1] - steps_at[0] == measure_to - measure_from);
+      CHECK((host.algorithm->clock_tracker.period_q4 + 8) / 16 == (uint32_t)slow);
+    }
+  }
+
+  TEST_CASE("Clock timeout set after the clock stopped counts from the change")
+  {
+    const int numFramesBy4 = 8;
+    const int n = numFramesBy4 * 4;
+    const int period = 480;
+    const int last_edge = 7;
+    const int set_at = 100 * period; // A block boundary, long after the clock stopped
+    const int end = 110 * period;
+
+    NtGridsTestHost host;
+    route_outputs_replace(host);
+    host.setParameter(kParamTrig1Length, 1);
+
+    std::vector<int> onsets;
+    std::vector<float> bus(kNumBuses * n, 0.0f);
+    float previous = 0.0f;
+    for (int block = 0; block * n < end; ++block)
+    {
+      if (block * n == set_at)
+        host.setParameter(kParamClockTimeout, 2);
+      for (int s = 0; s < n; ++s)
+      {
+        const int t = block * n + s;
+        bus[kClockBus * n + s] = (t / period <= last_edge && t % period < 10) ? 5.0f : 0.0f;
+      }
+      host.step(bus, numFramesBy4);
+      collect_trig1_onsets(bus, n, block, &previous, &onsets);
+    }
+
+    // No burst for the periods missed while the timeout was off: two periods after the change
+    // the two steps of the timeout play, then a tick a period.
+    std::vector<int> tick_samples, tick_counts;
+    for (int k = 0; k <= last_edge; ++k)
+    {
+      tick_samples.push_back(k * period);
+      tick_counts.push_back(1);
+    }
+    for (int k = 2; set_at + k * period < end; ++k)
+    {
+      tick_samples.push_back(set_at + k * period);
+      tick_counts.push_back(k == 2 ? 2 : 1);
+    }
+    const std::vector<int> expected = expected_trig1_onsets(tick_samples, tick_counts);
+    REQUIRE(expected.size() >= 8);
+    CHECK(onsets == expected);
+    CHECK(host.algorithm->clock_tracker.freewheeling);
+    CHECK(host.algorithm->clock_tracker.freewheeled == 9);
+  }
+
+  TEST_CASE("Clock multiplier predicts sub-ticks from the tracked period; divider plays every nth edge")
+  {
+    const int numFramesBy4 = 8;
+    const int n = numFramesBy4 * 4;
+    const int period = 960;
+    const int num_edges = 24;
+    const int scale_params[2] = {6, 1}; // x4, /3
+    for (int c = 0; c < 2; ++c)
+    {
+      CAPTURE(c);
+      NtGridsTestHost host;
+      route_outputs_replace(host);
+      host.setParameter(kParamTrig1Length, 1);
+      StepKernel unscaled = host.algorithm->step_kernel;
+      host.setParameter(kParamClockScale, scale_params[c]);
+      CHECK(host.algorithm->step_kernel != unscaled);
+
+      std::vector<float> bus(kNumBuses * n, 0.0f);
+      std::vector<int> onsets;
+      float previous = 0.0f;
+      for (int block = 0; block * n < num_edges * period; ++block)
+      {
+        for (int s = 0; s < n; ++s)
+        {
+          bus[kClockBus * n + s] = ((block * n + s) % period < 10) ? 5.0f : 0.0f;
+        }
+        host.step(bus, numFramesBy4);
+        collect_trig1_onsets(bus, n, block, &previous, &onsets);
+      }
+
+      // x4: the first edge plays alone (no period yet) and its three sub-ticks are caught up on
+      // the second edge; from there every edge plays and schedules three sub-ticks a quarter
+      // period apart. /3: the first edge and every third after it play.
+      std::vector<int> tick_samples, tick_counts;
+      int total_ticks = 0;
+      for (int k = 0; k < num_edges; ++k)
+      {
+        const int subticks = (c == 0) ? ((k == 0) ? 1 : 4) : ((k % 3 == 0) ? 1 : 0);
+        for (int j = 0; j < subticks; ++j)
+        {
+          tick_samples.push_back(k * period + j * period / 4);
+          tick_counts.push_back((c == 0 && k == 1 && j == 0) ? 4 : 1);
+          total_ticks += tick_counts.back();
+        }
+      }
+      CHECK(total_ticks == ((c == 0) ? 4 * num_edges : num_edges / 3)); // Nothing left behind
+      const std::vector<int> expected = expected_trig1_onsets(tick_samples, tick_counts);
+      REQUIRE(expected.size() >= 3);
+      CHECK(onsets == expected);
+      nt_grids_port::grids::PatternGenerator reference;
+      reference.Init();
+      for (int t = 0; t < total_ticks; ++t)
+        reference.TickClock(true);
+      CHECK(host.algorithm->pattern_generator.step() == reference.step());
+      CHECK(host.algorithm->pattern_generator.bar() == reference.bar());
+
+      host.setParameter(kParamClockScale, 3); // x1
+      CHECK(host.algorithm->step_kernel == unscaled);
+    }
+  }
+
+  TEST_CASE("A fast clock at x24 keeps every step's trigger in a full block")
+  {
+    // A 12-sample clock at x24 plays two steps a sample: far more ticks than frames in a block.
+    const int numFramesBy4 = 32;
+    const int n = numFramesBy4 * 4;
+    const int period = 12;
+    const int num_blocks = 40;
+    NtGridsTestHost host;
+    route_outputs_replace(host);
+    host.setParameter(kParamMode, 0); // Euclidean
+    host.setParameter(kParamEuclideanLength1, 32);
+    host.setParameter(kParamEuclideanFill1, 1);
+    host.setParameter(kParamTrig1Length, 1);
+    host.setParameter(kParamClockScale, 10); // x24
+
+    std::vector<float> bus(kNumBuses * n, 0.0f);
+    std::vector<int> onsets;
+    float previous = 0.0f;
+    for (int block = 0; block <= num_blocks; ++block)
+    {
+      for (int s = 0; s < n; ++s)
+      {
+        bus[kClockBus * n + s] = (block < num_blocks && (block * n + s) % period < period / 2) ? 5.0f : 0.0f;
+      }
+      host.step(bus, numFramesBy4);
+      collect_trig1_onsets(bus, n, block, &previous, &onsets);
+    }
+
+    // One hit every 32 steps, so each hit has its own onset however the steps share samples.
+    nt_grids_port::grids::PatternGenerator &generator = host.algorithm->pattern_generator;
+    const uint32_t total_ticks = generator.bar() * nt_grids_port::kStepsPerPattern + generator.step();
+    NtGridsTestHost reference;
+    route_outputs_replace(reference);
+    reference.setParameter(kParamMode, 0);
+    reference.setParameter(kParamEuclideanLength1, 32);
+    reference.setParameter(kParamEuclideanFill1, 1);
+    size_t hits = 0;
+    for (uint32_t t = 0; t < total_ticks; ++t)
+    {
+      if (reference.algorithm->pattern_generator.TickClock(true) &&
+          (reference.algorithm->pattern_generator.get_trigger_state() & nt_grids_port::grids::OUTPUT_BIT_TRIG_1))
+        ++hits;
+    }
+    CHECK(total_ticks > 24u * num_blocks * n / period * 9 / 10);
+    REQUIRE(hits > 200);
+    CHECK(onsets.size() == hits);
+  }
+
+  TEST_CASE("Idle blocks are counted and leave Add-mode busses untouched")
+  {
+    const int numFramesBy4 = 8;
+    const int n = numFramesBy4 * 4;
+    NtGridsTestHost host;
+    route_outputs_replace(host);
+    host.setParameter(kParamOutputTrig1Mode, 0); // Add
+
+    std::vector<float> bus(kNumBuses * n, 1.25f);
+    for (int s = 0; s < n; ++s)
+    {
+      bus[kClockBus * n + s] = 0.0f;
+    }
+    uint32_t skipped_before = host.algorithm->idle_blocks_skipped;
+    host.step(bus, numFramesBy4);
+    CHECK(host.algorithm->idle_blocks_skipped == skipped_before + 1);
+    for (int s = 0; s < n; ++s)
+    {
+      CHECK(bus[kFirstOutputBus * n + s] == 1.25f);    // Add: untouched
+      CHECK(bus[(kFirstOutputBus + 1) * n + s] == 0.0f); // Replace: cleared
+    }
+
+    bus[kClockBus * n + n / 2] = 5.0f; // One clock edge: not idle
+    host.step(bus, numFramesBy4);
+    CHECK(host.algorithm->idle_blocks_skipped == skipped_before + 1);
+  }
+}
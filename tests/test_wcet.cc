@@ -0,0 +1,208 @@
+#include "doctest.h"
+#include "nt_grids_pattern_generator.h"
+
+#include <chrono>
+#include <cstring>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Worst-case execution harness for pattern evaluation. Each step's Evaluate (via Retrigger)
+// is measured with the hardware retired-instruction counter (Linux perf events). Where that
+// is unavailable (e.g. containers without perf access) it falls back to the x86 time-stamp
+// counter, then to wall-clock nanoseconds; those are noisy, so every step is measured a few
+// times and the minimum kept. Skipped by default: run with `-ts="WCET" --no-skip`.
+
+using nt_grids_port::grids::PatternGenerator;
+using nt_grids_port::grids::OUTPUT_MODE_DRUMS;
+using nt_grids_port::grids::OUTPUT_MODE_EUCLIDEAN;
+
+class TickCounter
+{
+public:
+  TickCounter() : fd_(-1), start_tsc_(0)
+  {
+#if defined(__linux__)
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+  }
+
+  ~TickCounter()
+  {
+#if defined(__linux__)
+    if (fd_ >= 0)
+      close(fd_);
+#endif
+  }
+
+  bool counts_instructions() const { return fd_ >= 0; }
+  std::string unit() const
+  {
+    if (counts_instructions())
+      return "instructions";
+#if defined(__x86_64__) || defined(__i386__)
+    return "TSC ticks (no perf counter)";
+#else
+    return "ns (no perf counter)";
+#endif
+  }
+
+  void start()
+  {
+#if defined(__linux__)
+    if (fd_ >= 0)
+    {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+      return;
+    }
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+    start_tsc_ = __rdtsc();
+#else
+    start_time_ = std::chrono::steady_clock::now();
+#endif
+  }
+
+  uint64_t stop()
+  {
+#if defined(__linux__)
+    if (fd_ >= 0)
+    {
+      ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+      uint64_t count = 0;
+      if (read(fd_, &count, sizeof(count)) != (ssize_t)sizeof(count))
+        return 0;
+      return count;
+    }
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc() - start_tsc_;
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                           start_time_)
+        .count();
+#endif
+  }
+
+private:
+  int fd_;
+  uint64_t start_tsc_;
+  std::chrono::steady_clock::time_point start_time_;
+};
+
+struct CostRange
+{
+  uint64_t min;
+  uint64_t max;
+  CostRange() : min(~0ull), max(0) {}
+  void add(uint64_t cost)
+  {
+    min = cost < min ? cost : min;
+    max = cost > max ? cost : max;
+  }
+};
+
+static const int kSweep[] = {0, 16, 32, 48, 64, 80, 96, 112, 128, 144, 160, 176, 192, 208, 224, 240, 255};
+static const int kSweepSize = sizeof(kSweep) / sizeof(kSweep[0]);
+static const int kChaos[] = {0, 1, 64, 192, 255}; // 0 = chaos off
+static const int kRepeats = 3;
+
+// Advances one step, then measures re-evaluating it kRepeats times and keeps the cheapest.
+static uint64_t measure_step(PatternGenerator &generator, TickCounter &counter)
+{
+  generator.TickClock(true);
+  uint64_t best = ~0ull;
+  for (int r = 0; r < kRepeats; ++r)
+  {
+    counter.start();
+    generator.Retrigger();
+    uint64_t cost = counter.stop();
+    best = cost < best ? cost : best;
+  }
+  return best;
+}
+
+TEST_SUITE("WCET")
+{
+  TEST_CASE("Worst-case Evaluate cost over the parameter space" * doctest::skip())
+  {
+    TickCounter counter;
+    PatternGenerator generator;
+    CostRange drums, euclidean, prepare, chaos;
+
+    generator.set_output_mode(OUTPUT_MODE_DRUMS);
+    generator.Reset();
+    for (int xi = 0; xi < kSweepSize; ++xi)
+      for (int yi = 0; yi < kSweepSize; ++yi)
+        for (int di = 0; di < kSweepSize; ++di)
+          for (int c = 0; c < 5; ++c)
+          {
+            nt_grids_port::grids::PatternGeneratorSettings &settings = generator.settings_[OUTPUT_MODE_DRUMS];
+            settings.options.drums.x = (uint8_t)kSweep[xi];
+            settings.options.drums.y = (uint8_t)kSweep[yi];
+            for (int p = 0; p < nt_grids_port::kNumParts; ++p)
+              settings.density[p] = (uint8_t)(kSweep[di] + p * 85);
+            settings.options.drums.randomness = (uint8_t)kChaos[c];
+            generator.set_global_chaos(kChaos[c] != 0);
+
+            counter.start();
+            generator.PrepareDrumLevels(); // Control-rate cost, reported separately
+            prepare.add(counter.stop());
+
+            for (int t = 0; t < nt_grids_port::kStepsPerPattern; ++t)
+            {
+              drums.add(measure_step(generator, counter));
+            }
+          }
+
+    generator.set_output_mode(OUTPUT_MODE_EUCLIDEAN);
+    generator.Reset();
+    for (int length = 1; length <= 32; ++length)
+      for (int fill = 0; fill <= 32; ++fill)
+        for (int c = 0; c < 5; ++c)
+        {
+          for (int p = 0; p < nt_grids_port::kNumParts; ++p)
+          {
+            generator.SetLength((uint8_t)p, (uint8_t)length);
+            generator.SetFill((uint8_t)p, (uint8_t)fill);
+          }
+          generator.settings_[OUTPUT_MODE_EUCLIDEAN].options.euclidean.chaos_amount = (uint8_t)kChaos[c];
+          generator.set_global_chaos(kChaos[c] != 0);
+
+          generator.set_seed((uint32_t)(length * 64 + fill)); // Forces the rebuild
+          counter.start();
+          generator.PrepareEuclideanChaos(); // Once per bar, reported separately
+          chaos.add(counter.stop());
+
+          for (int t = 0; t < 32; ++t)
+          {
+            euclidean.add(measure_step(generator, counter));
+          }
+        }
+
+    MESSAGE("Evaluate, drums:     min " << drums.min << ", max " << drums.max << " " << counter.unit());
+    MESSAGE("Evaluate, euclidean: min " << euclidean.min << ", max " << euclidean.max << " " << counter.unit());
+    MESSAGE("PrepareDrumLevels:   min " << prepare.min << ", max " << prepare.max << " " << counter.unit()
+                                         << " (control rate, only when X/Y change)");
+    MESSAGE("PrepareEuclideanChaos: min " << chaos.min << ", max " << chaos.max << " " << counter.unit()
+                                           << " (once per bar; the masks are drawn at every chaos amount)");
+    CHECK(drums.max > 0);
+  }
+}